@@ -0,0 +1,281 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "cflp_instance_reader.h"
+#include "cflp.h"
+
+// Solves every instance several times and reports the median, mean, standard deviation,
+// minimum and maximum of the load time, preprocessing time, nodes per second,
+// time to the first incumbent and time to the proven optimum.
+
+typedef enum
+{
+	BENCH_LOAD_MS,
+	BENCH_PREPROCESS_MS,
+	BENCH_NODES_PER_SEC,
+	BENCH_FIRST_INCUMBENT_MS,
+	BENCH_OPTIMAL_MS,
+	BENCH_METRIC_COUNT
+} bench_metric;
+
+const char *bench_metric_names[BENCH_METRIC_COUNT] = { "load_ms", "preprocess_ms", "nodes_per_sec", "first_incumbent_ms", "optimal_ms" };
+
+typedef struct
+{
+	long long start_us;
+	long long first_incumbent_us;
+	long long last_incumbent_us;
+	cflp_val upper_bound;
+	cflp_val lower_bound;
+} bench_context;
+
+void bench_set_solution(void* context, cflp_val new_upper_bound, size_t* new_solution, size_t new_solution_length)
+{
+	(void) new_solution;
+	(void) new_solution_length;
+	bench_context *bench = (bench_context *) context;
+	long long now = cflp_stats_now_us();
+	if (bench->first_incumbent_us < 0)
+	{
+		bench->first_incumbent_us = now - bench->start_us;
+	}
+	bench->last_incumbent_us = now - bench->start_us;
+	bench->upper_bound = new_upper_bound;
+}
+
+void bench_set_lower_bound(void* context, cflp_val new_lower_bound)
+{
+	((bench_context *) context)->lower_bound = new_lower_bound;
+}
+
+int bench_compare_doubles(const void *a, const void *b)
+{
+	double x = *(const double *) a;
+	double y = *(const double *) b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// prints median, mean, standard deviation, minimum and maximum of the valid (non NaN) values
+void bench_print_summary(FILE *file, double *values, size_t num, int csv)
+{
+	double *sorted = (double *) malloc(sizeof(double) * (num + 1));
+	size_t len = 0;
+	double sum = 0;
+	for (size_t i = 0; i < num; i++)
+	{
+		if (!isnan(values[i]))
+		{
+			sorted[len++] = values[i];
+			sum += values[i];
+		}
+	}
+	if (len == 0)
+	{
+		if (csv)
+		{
+			fprintf(file, ",,,,,");
+		}
+		else
+		{
+			fprintf(file, " %18s", "-");
+		}
+		free(sorted);
+		return;
+	}
+	qsort(sorted, len, sizeof(double), bench_compare_doubles);
+	double mean = sum / len;
+	double variance = 0;
+	for (size_t i = 0; i < len; i++)
+	{
+		variance += (sorted[i] - mean) * (sorted[i] - mean);
+	}
+	double stddev = len > 1 ? sqrt(variance / (len - 1)) : 0;
+	double median = len % 2 ? sorted[len / 2] : (sorted[len / 2 - 1] + sorted[len / 2]) / 2;
+	if (csv)
+	{
+		fprintf(file, ",%g,%g,%g,%g,%g", median, mean, stddev, sorted[0], sorted[len - 1]);
+	}
+	else
+	{
+		char cell[64];
+		snprintf(cell, sizeof(cell), "%.4g~%.2g", median, stddev);
+		fprintf(file, " %18s", cell);
+	}
+	free(sorted);
+}
+
+void bench_usage()
+{
+	fprintf(stderr, "Usage: cflp_bench [-runs n] [-time ms] [-threads n] [-deterministic] [-csv file] instance...\n");
+}
+
+int main(int argc, char **argv)
+{
+	int runs = 3;
+	long long time_limit_ms = 5000;
+	const char *csv_path = NULL;
+	int threads = 1;
+	int deterministic = 0;
+	int first_file = argc;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-runs") == 0 && i + 1 < argc)
+		{
+			runs = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-time") == 0 && i + 1 < argc)
+		{
+			time_limit_ms = atoll(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			threads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-deterministic") == 0)
+		{
+			deterministic = 1;
+		}
+		else if (strcmp(argv[i], "-csv") == 0 && i + 1 < argc)
+		{
+			csv_path = argv[++i];
+		}
+		else
+		{
+			first_file = i;
+			break;
+		}
+	}
+	if (first_file >= argc || runs <= 0)
+	{
+		bench_usage();
+		return 1;
+	}
+	if (!CFLP_STATS_ENABLED)
+	{
+		fprintf(stderr, "Statistics are disabled, nodes and preprocessing times are not measured\n");
+	}
+
+	FILE *csv = NULL;
+	if (csv_path != NULL)
+	{
+		csv = fopen(csv_path, "w");
+		if (csv == NULL)
+		{
+			perror(csv_path);
+			return 1;
+		}
+		fprintf(csv, "instance,objective,lower_bound,optimal_runs");
+		for (int m = 0; m < BENCH_METRIC_COUNT; m++)
+		{
+			const char *n = bench_metric_names[m];
+			fprintf(csv, ",%s_median,%s_mean,%s_stddev,%s_min,%s_max", n, n, n, n, n);
+		}
+		fprintf(csv, "\n");
+	}
+
+	printf("%-32s %10s %10s %7s", "instance", "objective", "bound", "optimal");
+	for (int m = 0; m < BENCH_METRIC_COUNT; m++)
+	{
+		printf(" %18s", bench_metric_names[m]);
+	}
+	printf("\n");
+
+	double *values[BENCH_METRIC_COUNT];
+	for (int m = 0; m < BENCH_METRIC_COUNT; m++)
+	{
+		values[m] = (double *) malloc(sizeof(double) * runs);
+	}
+
+	int failed = 0;
+	for (int f = first_file; f < argc; f++)
+	{
+		const char *path = argv[f];
+		const char *name = strrchr(path, '/') != NULL ? strrchr(path, '/') + 1 : path;
+		bench_context bench;
+		int optimal_runs = 0;
+		int r;
+		for (r = 0; r < runs; r++)
+		{
+			long long load_start = cflp_stats_now_us();
+			cflp_instance *instance = cflp_instance_reader_read_instance(path);
+			long long load_us = cflp_stats_now_us() - load_start;
+			if (instance == NULL)
+			{
+				perror(path);
+				break;
+			}
+
+			cflp_stats *stats = CFLP_STATS_ENABLED ? cflp_stats_create() : NULL;
+			bnb_options options;
+			bnb_options_init(&options);
+			options.on_solution = bench_set_solution;
+			options.on_lower_bound = bench_set_lower_bound;
+			options.time_limit_ms = time_limit_ms;
+			options.threads = threads;
+			options.deterministic = deterministic;
+			options.stats = stats;
+			bench.start_us = cflp_stats_now_us();
+			bench.first_incumbent_us = -1;
+			bench.last_incumbent_us = -1;
+			bench.upper_bound = CFLP_VAL_INVALID;
+			bench.lower_bound = CFLP_VAL_INVALID;
+			bnb_run(&bench, instance, &options);
+			int optimal = bench.upper_bound != CFLP_VAL_INVALID && bench.lower_bound >= bench.upper_bound;
+			optimal_runs += optimal;
+
+			values[BENCH_LOAD_MS][r] = load_us / 1000.0;
+			values[BENCH_PREPROCESS_MS][r] = NAN;
+			values[BENCH_NODES_PER_SEC][r] = NAN;
+			if (stats != NULL)
+			{
+				long long search_us = cflp_stats_phase_us(stats, CFLP_PHASE_SEARCH);
+				values[BENCH_PREPROCESS_MS][r] = cflp_stats_phase_us(stats, CFLP_PHASE_PREPROCESS) / 1000.0;
+				values[BENCH_NODES_PER_SEC][r] = search_us > 0 ? stats->nodes * 1e6 / search_us : NAN;
+				cflp_stats_free(stats);
+			}
+			values[BENCH_FIRST_INCUMBENT_MS][r] = bench.first_incumbent_us >= 0 ? bench.first_incumbent_us / 1000.0 : NAN;
+			values[BENCH_OPTIMAL_MS][r] = optimal ? bench.last_incumbent_us / 1000.0 : NAN;
+
+			cflp_instance_free(instance);
+		}
+		if (r < runs)
+		{
+			failed = 1;
+			continue;
+		}
+
+		char optimal_cell[32];
+		snprintf(optimal_cell, sizeof(optimal_cell), "%d/%d", optimal_runs, runs);
+		printf("%-32s %10" CFLP_VAL_FMT " %10" CFLP_VAL_FMT " %7s", name, bench.upper_bound, bench.lower_bound, optimal_cell);
+		if (csv != NULL)
+		{
+			fprintf(csv, "%s,%" CFLP_VAL_FMT ",%" CFLP_VAL_FMT ",%d", name, bench.upper_bound, bench.lower_bound, optimal_runs);
+		}
+		for (int m = 0; m < BENCH_METRIC_COUNT; m++)
+		{
+			bench_print_summary(stdout, values[m], runs, 0);
+			if (csv != NULL)
+			{
+				bench_print_summary(csv, values[m], runs, 1);
+			}
+		}
+		printf("\n");
+		if (csv != NULL)
+		{
+			fprintf(csv, "\n");
+		}
+		fflush(stdout);
+	}
+	printf("(median~stddev over %d runs, time limit %lldms, - if never reached)\n", runs, time_limit_ms);
+
+	for (int m = 0; m < BENCH_METRIC_COUNT; m++)
+	{
+		free(values[m]);
+	}
+	if (csv != NULL)
+	{
+		fclose(csv);
+	}
+	return failed;
+}
@@ -0,0 +1,358 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+// Generates random CFLP instances in the text format of cflp_instance_reader.
+// The output only depends on the parameters and the seed.
+
+typedef struct
+{
+	size_t num_facilities;
+	size_t num_customers;
+	int clustered; // customers are grouped around a few centers instead of uniformly distributed
+	int tight_bandwidth; // MAXBANDWIDTH leaves little room over the average facility load
+	int tight_customers; // MAXCUSTOMERS leaves little room over the average number of customers
+	int distance_costs;
+	unsigned long long seed;
+} gen_params;
+
+typedef struct
+{
+	const char *name;
+	size_t num_facilities;
+	size_t num_customers;
+	int clustered;
+	int tight_bandwidth;
+	int tight_customers;
+} gen_suite_entry;
+
+// the instances of a suite are generated with the seeds 1, 2, 3, ...
+const gen_suite_entry gen_suite_small[] = {
+	{ "u10x10_loose", 10, 10, 0, 0, 0 },
+	{ "u10x20_tight", 10, 20, 0, 1, 1 },
+	{ "c10x20_loose", 10, 20, 1, 0, 0 },
+	{ "c15x30_tight", 15, 30, 1, 1, 1 },
+	{ NULL, 0, 0, 0, 0, 0 }
+};
+
+const gen_suite_entry gen_suite_default[] = {
+	{ "u10x10_loose", 10, 10, 0, 0, 0 },
+	{ "u10x10_tight", 10, 10, 0, 1, 1 },
+	{ "c10x20_loose", 10, 20, 1, 0, 0 },
+	{ "c10x20_tight", 10, 20, 1, 1, 1 },
+	{ "u20x40_bw", 20, 40, 0, 1, 0 },
+	{ "u20x40_cus", 20, 40, 0, 0, 1 },
+	{ "c50x100_loose", 50, 100, 1, 0, 0 },
+	{ "c50x100_tight", 50, 100, 1, 1, 1 },
+	{ "u100x500_loose", 100, 500, 0, 0, 0 },
+	{ "u100x500_tight", 100, 500, 0, 1, 1 },
+	{ "c100x1000_tight", 100, 1000, 1, 1, 1 },
+	{ NULL, 0, 0, 0, 0, 0 }
+};
+
+const gen_suite_entry gen_suite_large[] = {
+	{ "u1000x1000_loose", 1000, 1000, 0, 0, 0 },
+	{ "c1000x1000_tight", 1000, 1000, 1, 1, 1 },
+	{ "u1000x10000_tight", 1000, 10000, 0, 1, 1 },
+	{ "c10000x10000_loose", 10000, 10000, 1, 0, 0 },
+	{ "u10000x10000_tight", 10000, 10000, 0, 1, 1 },
+	{ NULL, 0, 0, 0, 0, 0 }
+};
+
+unsigned long long gen_next(unsigned long long *state)
+{
+	// splitmix64
+	unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+double gen_uniform(unsigned long long *state)
+{
+	return (gen_next(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+int gen_range(unsigned long long *state, int low, int high)
+{
+	return low + (int) (gen_uniform(state) * (high - low + 1));
+}
+
+#define GEN_AREA 1000.0
+
+void gen_point(unsigned long long *state, int clustered, double *centers, size_t num_centers, double *x, double *y)
+{
+	if (clustered)
+	{
+		size_t c = gen_next(state) % num_centers;
+		// sum of uniforms as cheap bell curve around the center
+		double dx = (gen_uniform(state) + gen_uniform(state) + gen_uniform(state) - 1.5) * GEN_AREA / 20;
+		double dy = (gen_uniform(state) + gen_uniform(state) + gen_uniform(state) - 1.5) * GEN_AREA / 20;
+		*x = fmin(fmax(centers[2 * c] + dx, 0), GEN_AREA);
+		*y = fmin(fmax(centers[2 * c + 1] + dy, 0), GEN_AREA);
+	}
+	else
+	{
+		*x = gen_uniform(state) * GEN_AREA;
+		*y = gen_uniform(state) * GEN_AREA;
+	}
+}
+
+int gen_write(FILE *file, gen_params *params)
+{
+	size_t num_facilities = params->num_facilities;
+	size_t num_customers = params->num_customers;
+	unsigned long long state = params->seed;
+
+	size_t num_centers = num_customers / 50 < 2 ? 2 : num_customers / 50;
+	double *centers = (double *) malloc(sizeof(double) * 2 * num_centers);
+	for (size_t c = 0; c < num_centers; c++)
+	{
+		centers[2 * c] = gen_uniform(&state) * GEN_AREA;
+		centers[2 * c + 1] = gen_uniform(&state) * GEN_AREA;
+	}
+	double *facilities = (double *) malloc(sizeof(double) * 2 * num_facilities);
+	for (size_t k = 0; k < num_facilities; k++)
+	{
+		// clustered facilities are only partly placed near the customers
+		gen_point(&state, params->clustered && k % 2 == 0, centers, num_centers, &facilities[2 * k], &facilities[2 * k + 1]);
+	}
+
+	// customers are generated one at a time below, their bandwidths are drawn first from an own stream
+	unsigned long long bandwidth_seed = state ^ 0x5DEECE66DULL;
+	unsigned long long bandwidth_state = bandwidth_seed;
+	long long total_bandwidth = 0;
+	for (size_t i = 0; i < num_customers; i++)
+	{
+		total_bandwidth += gen_range(&bandwidth_state, 1, 100);
+	}
+	double bandwidth_factor = params->tight_bandwidth ? 1.25 : 4.0;
+	double customers_factor = params->tight_customers ? 1.25 : 4.0;
+	int max_bandwidth = (int) ceil(bandwidth_factor * total_bandwidth / num_facilities);
+	if (max_bandwidth < 100)
+	{
+		max_bandwidth = 100;
+	}
+	double average_customers = (double) num_customers / num_facilities;
+
+	int *max_customers = (int *) malloc(sizeof(int) * num_facilities);
+	int *opening_costs = (int *) malloc(sizeof(int) * num_facilities);
+	long long threshold = 0;
+	for (size_t k = 0; k < num_facilities; k++)
+	{
+		double spread = 0.75 + gen_uniform(&state) / 2;
+		max_customers[k] = (int) ceil(customers_factor * average_customers * spread);
+		if (max_customers[k] < 1)
+		{
+			max_customers[k] = 1;
+		}
+		// an open facility should cost about as much as connecting its average customers over a medium distance
+		opening_costs[k] = (int) ((0.5 + gen_uniform(&state)) * (average_customers + 1) * params->distance_costs * GEN_AREA / 8);
+		threshold += opening_costs[k];
+	}
+	threshold += (long long) num_customers * params->distance_costs * (long long) ceil(GEN_AREA * M_SQRT2);
+	if (threshold > INT_MAX)
+	{
+		threshold = INT_MAX;
+	}
+
+	fprintf(file, "# generated by cflp_gen: %zu facilities, %zu customers, %s, %s bandwidth, %s customers, seed %llu\n",
+			num_facilities, num_customers, params->clustered ? "clustered" : "uniform",
+			params->tight_bandwidth ? "tight" : "loose", params->tight_customers ? "tight" : "loose", params->seed);
+	fprintf(file, "THRESHOLD: %lld\n", threshold);
+	fprintf(file, "FACILITIES: %zu\n", num_facilities);
+	fprintf(file, "CUSTOMERS: %zu\n", num_customers);
+	fprintf(file, "MAXBANDWIDTH: %d\n", max_bandwidth);
+	fprintf(file, "MAXCUSTOMERS:");
+	for (size_t k = 0; k < num_facilities; k++)
+	{
+		fprintf(file, " %d", max_customers[k]);
+	}
+	fprintf(file, "\nDISTANCECOSTS: %d\n", params->distance_costs);
+	fprintf(file, "OPENINGCOSTS:");
+	for (size_t k = 0; k < num_facilities; k++)
+	{
+		fprintf(file, " %d", opening_costs[k]);
+	}
+	fprintf(file, "\n");
+
+	bandwidth_state = bandwidth_seed;
+	unsigned long long customer_state = state;
+	for (size_t i = 0; i < num_customers; i++)
+	{
+		double x, y;
+		gen_point(&customer_state, params->clustered, centers, num_centers, &x, &y);
+		fprintf(file, "%d;", gen_range(&bandwidth_state, 1, 100));
+		for (size_t k = 0; k < num_facilities; k++)
+		{
+			double dx = facilities[2 * k] - x;
+			double dy = facilities[2 * k + 1] - y;
+			fprintf(file, " %d", (int) lround(sqrt(dx * dx + dy * dy)));
+		}
+		fprintf(file, "\n");
+	}
+
+	free(opening_costs);
+	free(max_customers);
+	free(facilities);
+	free(centers);
+	return ferror(file) ? -1 : 0;
+}
+
+int gen_write_path(const char *path, gen_params *params)
+{
+	FILE *file = fopen(path, "w");
+	if (file == NULL)
+	{
+		perror(path);
+		return -1;
+	}
+	int res = gen_write(file, params);
+	if (fclose(file) != 0)
+	{
+		res = -1;
+	}
+	return res;
+}
+
+int gen_write_suite(const char *suite_name, const char *directory, gen_params *defaults)
+{
+	const gen_suite_entry *suite = NULL;
+	if (strcmp(suite_name, "small") == 0)
+	{
+		suite = gen_suite_small;
+	}
+	else if (strcmp(suite_name, "default") == 0)
+	{
+		suite = gen_suite_default;
+	}
+	else if (strcmp(suite_name, "large") == 0)
+	{
+		suite = gen_suite_large;
+	}
+	else
+	{
+		fprintf(stderr, "Unknown suite %s (small, default, large)\n", suite_name);
+		return -1;
+	}
+	mkdir(directory, 0755);
+	for (size_t i = 0; suite[i].name != NULL; i++)
+	{
+		gen_params params = *defaults;
+		params.num_facilities = suite[i].num_facilities;
+		params.num_customers = suite[i].num_customers;
+		params.clustered = suite[i].clustered;
+		params.tight_bandwidth = suite[i].tight_bandwidth;
+		params.tight_customers = suite[i].tight_customers;
+		params.seed = defaults->seed + i;
+		char path[4096];
+		snprintf(path, sizeof(path), "%s/%s_s%llu.txt", directory, suite[i].name, params.seed);
+		struct stat st;
+		if (stat(path, &st) == 0)
+		{
+			continue; // generated before, the output only depends on the name and the seed
+		}
+		if (gen_write_path(path, &params) != 0)
+		{
+			return -1;
+		}
+		printf("%s\n", path);
+	}
+	return 0;
+}
+
+void gen_usage()
+{
+	fprintf(stderr, "Usage: cflp_gen [-f facilities] [-c customers] [-g uniform|clustered] [-b tight|loose]\n"
+			"                [-m tight|loose] [-d distance costs] [-s seed] [-o file]\n"
+			"       cflp_gen -suite small|default|large [-s seed] -o directory\n");
+}
+
+int main(int argc, char **argv)
+{
+	gen_params params;
+	params.num_facilities = 10;
+	params.num_customers = 10;
+	params.clustered = 0;
+	params.tight_bandwidth = 0;
+	params.tight_customers = 0;
+	params.distance_costs = 3;
+	params.seed = 1;
+	const char *output = NULL;
+	const char *suite = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (i + 1 >= argc)
+		{
+			gen_usage();
+			return 1;
+		}
+		const char *value = argv[i + 1];
+		if (strcmp(argv[i], "-f") == 0)
+		{
+			params.num_facilities = strtoul(value, NULL, 10);
+		}
+		else if (strcmp(argv[i], "-c") == 0)
+		{
+			params.num_customers = strtoul(value, NULL, 10);
+		}
+		else if (strcmp(argv[i], "-g") == 0)
+		{
+			params.clustered = strcmp(value, "clustered") == 0;
+		}
+		else if (strcmp(argv[i], "-b") == 0)
+		{
+			params.tight_bandwidth = strcmp(value, "tight") == 0;
+		}
+		else if (strcmp(argv[i], "-m") == 0)
+		{
+			params.tight_customers = strcmp(value, "tight") == 0;
+		}
+		else if (strcmp(argv[i], "-d") == 0)
+		{
+			params.distance_costs = atoi(value);
+		}
+		else if (strcmp(argv[i], "-s") == 0)
+		{
+			params.seed = strtoull(value, NULL, 10);
+		}
+		else if (strcmp(argv[i], "-o") == 0)
+		{
+			output = value;
+		}
+		else if (strcmp(argv[i], "-suite") == 0)
+		{
+			suite = value;
+		}
+		else
+		{
+			gen_usage();
+			return 1;
+		}
+		i++;
+	}
+	if (params.num_facilities == 0 || params.num_customers == 0 || params.distance_costs <= 0)
+	{
+		gen_usage();
+		return 1;
+	}
+
+	if (suite != NULL)
+	{
+		if (output == NULL)
+		{
+			gen_usage();
+			return 1;
+		}
+		return gen_write_suite(suite, output, &params) == 0 ? 0 : 1;
+	}
+	if (output == NULL)
+	{
+		return gen_write(stdout, &params) == 0 ? 0 : 1;
+	}
+	return gen_write_path(output, &params) == 0 ? 0 : 1;
+}
@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "buffered_reader.h"
+#include "cflp_instance_reader.h"
+#include "cflp_stats.h"
+
+// Measures the throughput and the allocations of the text ingest layers on generated files
+// with different line lengths. Linked with -Wl,--wrap=malloc,... so that every allocation
+// of the measured code passes the counters below.
+
+unsigned long long io_bench_mallocs = 0;
+unsigned long long io_bench_frees = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t num, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size)
+{
+	io_bench_mallocs++;
+	return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t num, size_t size)
+{
+	io_bench_mallocs++;
+	return __real_calloc(num, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+	io_bench_mallocs++;
+	return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr)
+{
+	if (ptr != NULL)
+	{
+		io_bench_frees++;
+	}
+	__real_free(ptr);
+}
+
+typedef struct
+{
+	const char *layer;
+	size_t line_len;
+	unsigned long long bytes;
+	unsigned long long lines;
+	unsigned long long mallocs;
+	long long time_us;
+} io_bench_result;
+
+void io_bench_print(io_bench_result *result)
+{
+	double seconds = result->time_us / 1e6;
+	printf("%-24s %10zu %10.1f %14.2f %12llu\n", result->layer, result->line_len,
+		   seconds > 0 ? result->bytes / seconds / (1024 * 1024) : 0.0,
+		   result->lines > 0 ? (double) result->mallocs / result->lines : 0.0, result->mallocs);
+}
+
+void io_bench_begin(io_bench_result *result, const char *layer, size_t line_len)
+{
+	result->layer = layer;
+	result->line_len = line_len;
+	result->bytes = 0;
+	result->lines = 0;
+	result->mallocs = io_bench_mallocs;
+	result->time_us = cflp_stats_now_us();
+}
+
+void io_bench_end(io_bench_result *result)
+{
+	result->time_us = cflp_stats_now_us() - result->time_us;
+	result->mallocs = io_bench_mallocs - result->mallocs;
+	io_bench_print(result);
+}
+
+// a line of space separated numbers like a row of the distance matrix, exactly line_len characters long
+void io_bench_line(char *line, size_t line_len, unsigned long long *state)
+{
+	size_t pos = 0;
+	while (pos < line_len)
+	{
+		*state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+		int number = (int) ((*state >> 33) % 1000);
+		int written = snprintf(line + pos, line_len - pos + 1, pos == 0 ? "%d" : " %d", number);
+		pos += written;
+	}
+	line[line_len] = '\0';
+	if (line[line_len - 1] == ' ')
+	{
+		line[line_len - 1] = '0';
+	}
+}
+
+size_t io_bench_count_numbers(const char *line, size_t line_len)
+{
+	size_t num = 0;
+	for (size_t i = 0; i < line_len; i++)
+	{
+		if (line[i] != ' ' && (i == 0 || line[i - 1] == ' '))
+		{
+			num++;
+		}
+	}
+	return num;
+}
+
+int io_bench_run(const char *directory, size_t line_len, size_t file_size)
+{
+	size_t num_lines = file_size / (line_len + 1);
+	if (num_lines == 0)
+	{
+		num_lines = 1;
+	}
+	char *line = (char *) __real_malloc(line_len + 1);
+	unsigned long long state = line_len;
+	io_bench_line(line, line_len, &state);
+	size_t numbers = io_bench_count_numbers(line, line_len);
+	cflp_val *array = (cflp_val *) __real_malloc(sizeof(cflp_val) * (numbers + 1));
+
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/io_bench_%zu.txt", directory, line_len);
+	FILE *file = fopen(path, "w");
+	if (file == NULL)
+	{
+		perror(path);
+		return -1;
+	}
+	for (size_t i = 0; i < num_lines; i++)
+	{
+		fputs(line, file);
+		fputc('\n', file);
+	}
+	fclose(file);
+
+	io_bench_result result;
+
+	// buffered_reader_read_line()
+	buffered_reader *reader = buffered_reader_create_path(path);
+	if (reader == NULL)
+	{
+		perror(path);
+		return -1;
+	}
+	io_bench_begin(&result, "buffered_reader", line_len);
+	const char *read;
+	while ((read = buffered_reader_read_line(reader)) != NULL)
+	{
+		result.bytes += line_len + 1;
+		result.lines++;
+	}
+	io_bench_end(&result);
+	buffered_reader_free(reader);
+
+	// block_buffer_append_character() + block_buffer_generate()
+	block_buffer *buffer = block_buffer_create();
+	io_bench_begin(&result, "block_buffer_character", line_len);
+	for (size_t i = 0; i < num_lines; i++)
+	{
+		block_buffer_clear(&buffer);
+		for (size_t k = 0; k < line_len; k++)
+		{
+			block_buffer_append_character(buffer, line[k]);
+		}
+		block_buffer_generate(buffer);
+		result.bytes += line_len;
+		result.lines++;
+	}
+	io_bench_end(&result);
+
+	// block_buffer_append_memory() + block_buffer_generate()
+	io_bench_begin(&result, "block_buffer_memory", line_len);
+	for (size_t i = 0; i < num_lines; i++)
+	{
+		block_buffer_clear(&buffer);
+		block_buffer_append_memory(buffer, line, line_len);
+		block_buffer_generate(buffer);
+		result.bytes += line_len;
+		result.lines++;
+	}
+	io_bench_end(&result);
+
+	// block_buffer_append_int() + block_buffer_generate(), a line of the same count of numbers
+	io_bench_begin(&result, "block_buffer_int", line_len);
+	for (size_t i = 0; i < num_lines; i++)
+	{
+		block_buffer_clear(&buffer);
+		for (size_t k = 0; k < numbers; k++)
+		{
+			block_buffer_append_int(buffer, (long long) (k * 7919 % 1000));
+			block_buffer_append_character(buffer, ' ');
+		}
+		block_buffer_generate(buffer);
+		result.bytes += line_len;
+		result.lines++;
+	}
+	io_bench_end(&result);
+	block_buffer_free(buffer);
+
+	// cflp_instance_reader_fill_int_list()
+	io_bench_begin(&result, "fill_int_list", line_len);
+	for (size_t i = 0; i < num_lines; i++)
+	{
+		if (cflp_instance_reader_fill_int_list(line, line_len, array, numbers) == NULL)
+		{
+			fprintf(stderr, "Could not parse line of length %zu\n", line_len);
+			return -1;
+		}
+		result.bytes += line_len;
+		result.lines++;
+	}
+	io_bench_end(&result);
+
+	remove(path);
+	__real_free(array);
+	__real_free(line);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	const char *directory = "/tmp";
+	size_t file_size = 16 * 1024 * 1024;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-dir") == 0 && i + 1 < argc)
+		{
+			directory = argv[++i];
+		}
+		else if (strcmp(argv[i], "-size") == 0 && i + 1 < argc)
+		{
+			file_size = strtoull(argv[++i], NULL, 10) * 1024 * 1024;
+		}
+		else
+		{
+			fprintf(stderr, "Usage: io_bench [-dir directory] [-size MB per file]\n");
+			return 1;
+		}
+	}
+
+	const size_t line_lens[] = { 16, 128, 1024, 8192, 65536 };
+	printf("%-24s %10s %10s %14s %12s\n", "layer", "line_len", "MB/s", "mallocs/line", "mallocs");
+	for (size_t i = 0; i < sizeof(line_lens) / sizeof(line_lens[0]); i++)
+	{
+		if (io_bench_run(directory, line_lens[i], file_size) != 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "cflp_instance_reader.h"
+#include "cflp_memory.h"
+#include "cflp.h"
+
+// Compares the page sizes and NUMA placements of cflp_memory.h: random reads of several threads on
+// an array like the distance matrix, and the parallel search on the given instances. On a machine
+// with one node the placements only differ by their overhead.
+
+const char *memory_bench_pages_names[] = { "small", "transparent", "explicit" };
+const char *memory_bench_placement_names[] = { "local", "interleave", "replicate" };
+
+typedef struct
+{
+	const cflp_distance *array; // shared array, NULL to read the own copy
+	size_t num;
+	unsigned long long reads;
+	int node; // -1 if not pinned
+	unsigned long long sum;
+	long long time_us; // of the reads without the copy
+} memory_bench_thread;
+
+// huge pages of the process in KiB, transparent and explicit ones
+long long memory_bench_huge_kb()
+{
+	FILE *file = fopen("/proc/self/smaps_rollup", "r");
+	if (file == NULL)
+	{
+		return -1;
+	}
+	long long total = 0;
+	char line[256];
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		long long kb;
+		if (sscanf(line, "AnonHugePages: %lld kB", &kb) == 1 || sscanf(line, "Private_Hugetlb: %lld kB", &kb) == 1)
+		{
+			total += kb;
+		}
+	}
+	fclose(file);
+	return total;
+}
+
+cflp_distance *memory_bench_array(size_t num)
+{
+	cflp_distance *array = (cflp_distance *) cflp_memory_alloc(sizeof(cflp_distance) * num);
+	if (array == NULL)
+	{
+		return NULL;
+	}
+	for (size_t i = 0; i < num; i++)
+	{
+		array[i] = (cflp_distance) (i * 2654435761ULL);
+	}
+	return array;
+}
+
+void *memory_bench_reader(void *param)
+{
+	memory_bench_thread *thread = (memory_bench_thread *) param;
+	if (thread->node >= 0)
+	{
+		cflp_memory_pin_thread(pthread_self(), thread->node);
+	}
+	const cflp_distance *array = thread->array;
+	cflp_distance *own = NULL;
+	if (array == NULL)
+	{
+		own = (cflp_distance *) cflp_memory_alloc(sizeof(cflp_distance) * thread->num);
+		cflp_memory_bind(own, thread->node);
+		for (size_t i = 0; i < thread->num; i++)
+		{
+			own[i] = (cflp_distance) (i * 2654435761ULL);
+		}
+		array = own;
+	}
+	unsigned long long state = (unsigned long long) (size_t) thread;
+	unsigned long long sum = 0;
+	long long begin_us = cflp_stats_now_us();
+	for (unsigned long long r = 0; r < thread->reads; r++)
+	{
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		sum += (unsigned int) array[(state >> 17) % thread->num];
+	}
+	thread->time_us = cflp_stats_now_us() - begin_us;
+	thread->sum = sum;
+	cflp_memory_free(own);
+	return NULL;
+}
+
+// random reads per thread, the replicated placement reads a copy of its node
+int memory_bench_reads(cflp_pages pages, cflp_placement placement, size_t size_mb, int threads, unsigned long long reads)
+{
+	cflp_memory_set_pages(pages);
+	size_t num = size_mb * 1024 * 1024 / sizeof(cflp_distance);
+	long long huge_before = memory_bench_huge_kb();
+	cflp_distance *array = NULL;
+	if (placement != CFLP_PLACEMENT_REPLICATE)
+	{
+		array = memory_bench_array(num);
+		if (array == NULL)
+		{
+			fprintf(stderr, "Could not allocate %zu MB\n", size_mb);
+			return -1;
+		}
+		if (placement == CFLP_PLACEMENT_INTERLEAVE)
+		{
+			cflp_memory_interleave(array);
+		}
+	}
+	int nodes[CFLP_MEMORY_MAX_NODES];
+	int num_nodes = cflp_memory_nodes(nodes, CFLP_MEMORY_MAX_NODES);
+	memory_bench_thread *params = (memory_bench_thread *) malloc(sizeof(memory_bench_thread) * threads);
+	pthread_t *handles = (pthread_t *) malloc(sizeof(pthread_t) * threads);
+	for (int t = 0; t < threads; t++)
+	{
+		params[t].array = array;
+		params[t].num = num;
+		params[t].reads = reads;
+		params[t].node = placement == CFLP_PLACEMENT_REPLICATE ? nodes[t % num_nodes] : -1;
+		pthread_create(&handles[t], NULL, memory_bench_reader, &params[t]);
+	}
+	long long time_us = 0; // of the slowest thread
+	for (int t = 0; t < threads; t++)
+	{
+		pthread_join(handles[t], NULL);
+		time_us = params[t].time_us > time_us ? params[t].time_us : time_us;
+	}
+	long long huge_kb = placement != CFLP_PLACEMENT_REPLICATE ? memory_bench_huge_kb() - huge_before : -1;
+	printf("%-12s %-10s %8d %8zu %12.2f %10lld\n", memory_bench_pages_names[pages], memory_bench_placement_names[placement],
+		   threads, size_mb, time_us * 1000.0 / (reads * threads), huge_kb >= 0 ? huge_kb / 1024 : -1);
+	cflp_memory_free(array);
+	free(handles);
+	free(params);
+	return 0;
+}
+
+int memory_bench_solve(const char *path, cflp_pages pages, cflp_placement placement, int threads, long long time_limit_ms)
+{
+	cflp_memory_set_pages(pages);
+	cflp_instance *instance = cflp_instance_reader_read_instance(path);
+	if (instance == NULL)
+	{
+		fprintf(stderr, "Could not read %s\n", path);
+		return -1;
+	}
+	cflp_stats *stats = CFLP_STATS_ENABLED ? cflp_stats_create() : NULL;
+	bnb_options options;
+	bnb_options_init(&options);
+	options.threads = threads;
+	options.placement = placement;
+	options.time_limit_ms = time_limit_ms;
+	options.stats = stats;
+	long long begin_us = cflp_stats_now_us();
+	bnb_status status = bnb_run(NULL, instance, &options);
+	long long time_us = cflp_stats_now_us() - begin_us;
+	unsigned long long nodes = stats != NULL ? stats->nodes : 0;
+	printf("%-32s %-12s %-10s %8d %10lld %14.0f %s\n", path, memory_bench_pages_names[pages], memory_bench_placement_names[placement],
+		   threads, time_us / 1000, time_us > 0 ? nodes * 1e6 / time_us : 0.0, status == BNB_COMPLETE ? "complete" : "stopped");
+	if (stats != NULL)
+	{
+		cflp_stats_free(stats);
+	}
+	cflp_instance_free(instance);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	size_t size_mb = 256;
+	int threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned long long reads = 10000000;
+	long long time_limit_ms = 5000;
+	int first_file = argc;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-size") == 0 && i + 1 < argc)
+		{
+			size_mb = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			threads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-reads") == 0 && i + 1 < argc)
+		{
+			reads = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "-time") == 0 && i + 1 < argc)
+		{
+			time_limit_ms = atoll(argv[++i]);
+		}
+		else if (argv[i][0] == '-')
+		{
+			fprintf(stderr, "Usage: memory_bench [-size MB] [-threads N] [-reads per thread] [-time ms per solve] [instances]\n");
+			return 1;
+		}
+		else
+		{
+			first_file = i;
+			break;
+		}
+	}
+	if (threads <= 0 || size_mb == 0 || reads == 0)
+	{
+		fprintf(stderr, "Invalid arguments\n");
+		return 1;
+	}
+
+	printf("%d NUMA node(s)\n", cflp_memory_num_nodes());
+	printf("%-12s %-10s %8s %8s %12s %10s\n", "pages", "placement", "threads", "MB", "ns/read", "huge_MB");
+	for (int pages = CFLP_PAGES_SMALL; pages <= CFLP_PAGES_EXPLICIT; pages++)
+	{
+		for (int placement = CFLP_PLACEMENT_LOCAL; placement <= CFLP_PLACEMENT_REPLICATE; placement++)
+		{
+			if (memory_bench_reads((cflp_pages) pages, (cflp_placement) placement, size_mb, threads, reads) != 0)
+			{
+				return 1;
+			}
+		}
+	}
+
+	if (first_file < argc)
+	{
+		printf("\n%-32s %-12s %-10s %8s %10s %14s %s\n", "instance", "pages", "placement", "threads", "ms", "nodes_per_sec", "status");
+	}
+	for (int i = first_file; i < argc; i++)
+	{
+		for (int pages = CFLP_PAGES_SMALL; pages <= CFLP_PAGES_EXPLICIT; pages++)
+		{
+			for (int placement = CFLP_PLACEMENT_LOCAL; placement <= CFLP_PLACEMENT_REPLICATE; placement++)
+			{
+				if (memory_bench_solve(argv[i], (cflp_pages) pages, (cflp_placement) placement, threads, time_limit_ms) != 0)
+				{
+					return 1;
+				}
+			}
+		}
+	}
+	return 0;
+}
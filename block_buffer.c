@@ -13,16 +13,19 @@
 
 struct block_buffer_segment_s* block_buffer_segment_create(size_t segment_size)
 {
-	struct block_buffer_segment_s* segment = (struct block_buffer_segment_s*)malloc(sizeof(struct block_buffer_segment_s));
+	// header and memory in one allocation, plus the terminating '\0'
+	struct block_buffer_segment_s* segment = (struct block_buffer_segment_s*)malloc(sizeof(struct block_buffer_segment_s) + segment_size + 1);
 	segment->buffer_size = segment_size;
-	segment->buffer = (char*)malloc(segment_size * sizeof(char));
 	segment->next = NULL;
 	return segment;
 }
 
 void block_buffer_add_segment(block_buffer *buffer, size_t segment_size)
 {
-	buffer->current->next = block_buffer_segment_create(segment_size);
+	if (buffer->current->next == NULL)
+	{
+		buffer->current->next = block_buffer_segment_create(segment_size);
+	}
 	buffer->current = buffer->current->next;
 	buffer->position = 0;
 }
@@ -30,9 +33,6 @@ void block_buffer_add_segment(block_buffer *buffer, size_t segment_size)
 void block_buffer_free_segment(struct block_buffer_segment_s* segment)
 {
 	segment->next = NULL;
-	free(segment->buffer);
-	segment->buffer = NULL;
-
 	free(segment);
 }
 
@@ -50,6 +50,7 @@ block_buffer *block_buffer_create_len(size_t segment_size)
 	}
 	block_buffer *buffer = (block_buffer *) malloc(sizeof(block_buffer));
 	buffer->buffer = NULL;
+	buffer->buffer_capacity = 0;
 	buffer->buffer_changed = 1;
 	buffer->position = 0;
 	buffer->segment_size = segment_size;
@@ -70,12 +71,7 @@ void block_buffer_append_memory(block_buffer *buffer, const char *memory, size_t
 		return;
 	}
 	buffer->buffer_changed = 1;
-	if (buffer->position + memory_len <= buffer->current->buffer_size)
-	{
-		memcpy(buffer->current->buffer + buffer->position, memory, memory_len);
-		buffer->position += memory_len;
-	}
-	else
+	while (buffer->position + memory_len > buffer->current->buffer_size)
 	{
 		size_t copy_len = buffer->current->buffer_size - buffer->position;
 		if (copy_len > 0)
@@ -86,98 +82,138 @@ void block_buffer_append_memory(block_buffer *buffer, const char *memory, size_t
 			memory_len -= copy_len;
 		}
 		block_buffer_add_segment(buffer, max(buffer->segment_size, memory_len));
-		block_buffer_append_memory(buffer, memory, memory_len);
 	}
+	memcpy(buffer->current->buffer + buffer->position, memory, memory_len);
+	buffer->position += memory_len;
 }
 
 void block_buffer_append_character(block_buffer *buffer, const char character)
 {
 	buffer->buffer_changed = 1;
-	if (buffer->position < buffer->current->buffer_size)
-	{
-		buffer->current->buffer[buffer->position++] = character;
-	}
-	else
+	if (buffer->position >= buffer->current->buffer_size)
 	{
 		block_buffer_add_segment(buffer, buffer->segment_size);
-		block_buffer_append_character(buffer, character);
 	}
+	buffer->current->buffer[buffer->position++] = character;
 }
 
 void block_buffer_append_int(block_buffer *buffer, long long number)
 {
-	if (number < 0) {
-		block_buffer_append_character(buffer, '-');
-		number = -number;
+	char digits[24]; // 19 digits and the sign of a 64 bit number
+	char* pointer = digits + sizeof(digits);
+	unsigned long long value = number < 0 ? 0ULL - (unsigned long long) number : (unsigned long long) number;
+	do
+	{
+		*--pointer = '0' + value % 10;
+		value /= 10;
+	} while (value != 0);
+	if (number < 0)
+	{
+		*--pointer = '-';
 	}
-	else
+	block_buffer_append_memory(buffer, pointer, digits + sizeof(digits) - pointer);
+}
+
+size_t block_buffer_length(block_buffer *buffer)
+{
+	size_t buffer_len = buffer->position;
+	for (struct block_buffer_segment_s* pointer = buffer->head; pointer != buffer->current; pointer = pointer->next)
 	{
-		long long next = number / 10;
-		char character = '0' + number % 10;
-		if (next != 0)
-		{
-			block_buffer_append_int(buffer, next);
-		}
-		block_buffer_append_character(buffer, character);
+		buffer_len += pointer->buffer_size;
 	}
+	return buffer_len;
 }
 
-const char *block_buffer_generate(block_buffer *buffer)
+const char *block_buffer_view(block_buffer *buffer, size_t *length)
 {
-	if (buffer->buffer_changed)
+	if (buffer->current == buffer->head)
 	{
-		if (buffer->buffer != NULL)
+		// contiguous, every segment has room for the '\0'
+		buffer->head->buffer[buffer->position] = '\0';
+		buffer->buffer_changed = 0;
+		if (length != NULL)
 		{
-			free(buffer->buffer);
-			buffer->buffer = NULL;
+			*length = buffer->position;
 		}
+		return buffer->head->buffer;
 	}
 
-	if (buffer->buffer == NULL)
+	size_t buffer_len = block_buffer_length(buffer);
+	if (buffer->buffer_changed)
 	{
-		size_t buffer_len = 0;
-		struct block_buffer_segment_s* pointer = buffer->head;
-		while (pointer != NULL)
+		if (buffer->buffer_capacity < buffer_len + 1) // buffer_len + escape char '\0'
 		{
-			if (pointer->next == NULL)
-			{
-				buffer_len += buffer->position;
-			}
-			else
-			{
-				buffer_len += pointer->buffer_size;
-			}
-			pointer = pointer->next;
+			free(buffer->buffer);
+			buffer->buffer = (char*)malloc(buffer_len + 1);
+			buffer->buffer_capacity = buffer_len + 1;
 		}
-		buffer->buffer = (char*)malloc(buffer_len + 1); // buffer_len + escape char '\0'
 
-		pointer = buffer->head;
 		char* memory = buffer->buffer;
-		while (pointer != NULL)
+		for (struct block_buffer_segment_s* pointer = buffer->head; pointer != buffer->current; pointer = pointer->next)
 		{
-			if (pointer->next == NULL)
-			{
-				memcpy(memory, pointer->buffer, buffer->position);
-				memory += buffer->position;
-			}
-			else
-			{
-				memcpy(memory, pointer->buffer, pointer->buffer_size);
-				memory += pointer->buffer_size;
-			}
-			pointer = pointer->next;
+			memcpy(memory, pointer->buffer, pointer->buffer_size);
+			memory += pointer->buffer_size;
 		}
+		memcpy(memory, buffer->current->buffer, buffer->position);
+		memory += buffer->position;
 		*memory = '\0';
+		buffer->buffer_changed = 0;
 	}
 
-	buffer->buffer_changed = 0;
+	if (length != NULL)
+	{
+		*length = buffer_len;
+	}
 	return buffer->buffer;
 }
 
+const char *block_buffer_generate(block_buffer *buffer)
+{
+	return block_buffer_view(buffer, NULL);
+}
+
+int block_buffer_iovec(block_buffer *buffer, struct iovec *iov, int iov_len)
+{
+	int count = 0;
+	for (struct block_buffer_segment_s* pointer = buffer->head; pointer != NULL; pointer = pointer->next)
+	{
+		size_t len = pointer == buffer->current ? buffer->position : pointer->buffer_size;
+		if (len > 0)
+		{
+			if (iov != NULL && count < iov_len)
+			{
+				iov[count].iov_base = pointer->buffer;
+				iov[count].iov_len = len;
+			}
+			count++;
+		}
+		if (pointer == buffer->current)
+		{
+			break;
+		}
+	}
+	return count;
+}
+
 void block_buffer_clear(block_buffer **buffer)
 {
-	block_buffer_free(*buffer);
-	*buffer = block_buffer_create();
+	block_buffer *buf = *buffer;
+	if (buf->head->next != NULL)
+	{
+		// merge the capacity into one segment, so the next content of this size stays contiguous
+		size_t capacity = 0;
+		while (buf->head != NULL)
+		{
+			struct block_buffer_segment_s* next = buf->head->next;
+			capacity += buf->head->buffer_size;
+			block_buffer_free_segment(buf->head);
+			buf->head = next;
+		}
+		buf->head = block_buffer_segment_create(capacity);
+	}
+	buf->current = buf->head;
+	buf->position = 0;
+	buf->buffer_changed = 1;
 }
 
 void block_buffer_free(block_buffer *buffer)
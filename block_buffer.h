@@ -1,22 +1,30 @@
 #include "types.h"
+#include <stddef.h>
+#include <sys/uio.h>
+
+#ifndef __BLOCK_BUFFER_HEADER
+#define __BLOCK_BUFFER_HEADER
 
 // #define BLOCK_BUFFER_DEFAULT_SIZE (rand()%100+1) // to test the block buffer
 #define BLOCK_BUFFER_DEFAULT_SIZE 128
 
 struct block_buffer_segment_s
 {
-	char* buffer;
-	size_t buffer_size;
+	size_t buffer_size; // usable bytes, the buffer has one more byte for the terminating '\0'
 	struct block_buffer_segment_s* next;
+	char buffer[];
 };
 
+// The segments are kept when the buffer is cleared and reused for the next content, so a buffer
+// that is cleared and refilled (e.g. per line or per token) stops allocating once it has grown.
 struct block_buffer_s
 {
 	struct block_buffer_segment_s* head;
-	struct block_buffer_segment_s* current;
+	struct block_buffer_segment_s* current; // segments after current are empty and reused by the next appends
 	size_t position;
 	size_t segment_size;
-	char* buffer;
+	char* buffer; // contiguous copy if the content spans more than one segment
+	size_t buffer_capacity;
 	int buffer_changed;
 };
 
@@ -34,8 +42,21 @@ void block_buffer_append_character(block_buffer *buffer, const char character);
 
 void block_buffer_append_int(block_buffer *buffer, long long number);
 
+size_t block_buffer_length(block_buffer *buffer);
+
+// returns the content as '\0' terminated string, valid until the buffer is changed
 const char *block_buffer_generate(block_buffer *buffer);
 
+// like block_buffer_generate() and stores the length of the content, never copies if the content is in one segment
+const char *block_buffer_view(block_buffer *buffer, size_t *length);
+
+// fills up to iov_len entries with the segments of the content (for writev) and returns the count of
+// entries the content needs, iov may be NULL to query the count
+int block_buffer_iovec(block_buffer *buffer, struct iovec *iov, int iov_len);
+
+// empties the buffer, the allocated capacity is kept (merged into one segment)
 void block_buffer_clear(block_buffer **buffer);
 
 void block_buffer_free(block_buffer *buffer);
+
+#endif
@@ -46,6 +46,21 @@ buffered_reader *buffered_reader_create_file_len(FILE *file, size_t buffer_len)
 	return reader;
 }
 
+int buffered_reader_reopen_path(buffered_reader *reader, const char *filename)
+{
+	FILE* file = fopen(filename, "r");
+	if (file == NULL)
+	{
+		return -1;
+	}
+	buffered_reader_close(reader);
+	reader->file = file;
+	reader->buffer_len = 0;
+	reader->buffer_pos = 0;
+	reader->skip_lf = 0;
+	return 0;
+}
+
 int burred_reader_empty(buffered_reader *reader)
 {
 	return reader->buffer_pos >= reader->buffer_len;
@@ -56,8 +71,14 @@ void buffered_reader_read_char(buffered_reader *reader)
 	if (burred_reader_empty(reader))
 	{
 		//reader->buffer_len = fread(reader->buffer, sizeof(char), reader->default_len, reader->file);
-		fgets(reader->buffer, reader->default_len, reader->file);
-		reader->buffer_len = strlen(reader->buffer);
+		if (fgets(reader->buffer, reader->default_len, reader->file) == NULL)
+		{
+			reader->buffer_len = 0; // end of file, the buffer still holds the last line
+		}
+		else
+		{
+			reader->buffer_len = strlen(reader->buffer);
+		}
 		reader->buffer_pos = 0;
 	}
 }
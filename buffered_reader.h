@@ -1,6 +1,9 @@
 #include <stdio.h>
 #include "block_buffer.h"
 
+#ifndef __BUFFERED_READER_HEADER
+#define __BUFFERED_READER_HEADER
+
 // #define BUFFERED_READER_DEFAULT_LEN (rand()%100+1) // to test the buffered reader
 #define BUFFERED_READER_DEFAULT_LEN 4096
 
@@ -28,8 +31,13 @@ buffered_reader *buffered_reader_create_path_len(const char *filename, size_t bu
 
 buffered_reader *buffered_reader_create_file_len(FILE *file, size_t buffer_len);
 
+// closes the current file and continues with the given one, keeps the allocated buffers; returns 0 on success
+int buffered_reader_reopen_path(buffered_reader *reader, const char *filename);
+
 const char *buffered_reader_read_line(buffered_reader *reader);
 
 void buffered_reader_close(buffered_reader *reader);
 
-void buffered_reader_free(buffered_reader *reader);
\ No newline at end of file
+void buffered_reader_free(buffered_reader *reader);
+
+#endif
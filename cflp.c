@@ -1,6 +1,16 @@
 #include "cflp.h"
+#include "cflp_memory.h"
+#include <errno.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 typedef struct
 {
@@ -11,10 +21,11 @@ typedef struct
 	cflp_val opening_costs;
 } facility_st;
 
+// the nearest lists are only read by the search, so the threads of a parallel search share them
 typedef struct facility_tuple_s
 {
 	cflp_val key;
-	facility_st *value;
+	size_t facility;
 	struct facility_tuple_s* next;
 } facility_tuple_st;
 
@@ -24,8 +35,9 @@ typedef struct customer_s
 	size_t num;
 	facility_tuple_st *nearest;
 	struct customer_s* next;
+	size_t depth;
 	cflp_val lower;
-	cflp_val cost;
+	facility_tuple_st *last; // last entry of a list with only the nearest facilities, NULL for a complete list
 } customer_st;
 
 typedef struct
@@ -112,103 +124,2410 @@ void removeUser(facility_st *facility, cflp_val bandwidth)
 	facility->bandwidth -= bandwidth;
 }
 
-void branch(void *context, customer_st *customer, size_t *solution, cflp_val *UpperBoundInclusive,
-			cflp_val maxBandwidth, size_t solution_len)
+
+// transposition table: two entries per bucket, the first keeps the state with the most customers left,
+// the second the most recent one; zeroed memory is empty
+typedef struct
 {
-	for (facility_tuple_st *facilityTuple = customer->nearest;
-		 facilityTuple != NULL; facilityTuple = facilityTuple->next) {
-		facility_st *facility = facilityTuple->value;
-		cflp_val newCost = customer->cost + recentCost(facility) + facilityTuple->key;
-		if (newCost + customer->lower <= *UpperBoundInclusive) { // L < U Bounding
-			int bandwidth = customer->key;
-			if (canAddUser(facility, maxBandwidth, bandwidth)) { // check if valid solution
-				solution[customer->num] = facility->num;
+	unsigned long long key; // hash of the facility states and the depth
+	cflp_val cost; // lowest costs of the customers before the depth that reached the state
+	unsigned int height; // customers left, 0 for an empty entry
+} table_entry_st;
+
+#define TABLE_BUCKET 2
+
+// state of a search shared by all its threads
+typedef struct
+{
+	pthread_mutex_t mutex; // serializes the incumbent updates and the callbacks
+	cflp_val incumbent;
+	cflp_val upper_bound_inc; // read atomically by the threads
+	bnb_status stop; // the first reason to stop, read atomically by the threads
+	int proven; // a solution reached options->lower_bound
+	// subproblems of a parallel search: the facilities of the first prefix_depth customers
+	size_t *prefixes;
+	cflp_val *prefix_costs;
+	size_t prefix_depth;
+	size_t prefix_count;
+	size_t prefix_capacity;
+	size_t prefix_next; // next subproblem to take, incremented atomically
+	// deterministic parallel search: in each epoch every thread searches one subproblem with the bound of
+	// the epoch start, then the calling thread publishes the best solution of the epoch
+	int deterministic;
+	pthread_cond_t epoch_cond; // with mutex
+	size_t epoch; // epochs started
+	int epoch_done; // threads through with the current epoch
+	int epoch_exit;
+	cflp_val *epoch_costs; // per thread, CFLP_VAL_MAX without solution
+	size_t *epoch_solutions; // per thread
+	int num_threads;
+} bnb_shared_st;
+
+typedef struct
+{
+	void *context;
+	facility_st *facilities; // own copy of each thread
+	size_t *solution;
+	size_t solution_len;
+	cflp_val max_bandwidth;
+	cflp_val upper_bound_inc; // only solutions with costs <= upper_bound_inc are searched
+	cflp_val pruned_lower; // smallest lower bound of all pruned subtrees
+	cflp_val tolerance_abs;
+	double tolerance_rel;
+	cflp_val target; // stop at the first solution with costs <= target
+	bnb_status stop; // BNB_COMPLETE while the search runs
+	const bnb_options *options;
+	long long deadline_us; // 0 for no time limit
+	unsigned int limit_countdown; // nodes until the next time limit check
+	cflp_stats *stats;
+	bnb_shared_st *shared;
+	customer_st *begin;
+	facility_tuple_st **guide; // facility per customer that is branched on first, may be NULL
+	// checkpoints, only of a sequential search
+	cflp_checkpoint_writer *checkpoint; // NULL without checkpoint file
+	unsigned long long instance_hash;
+	long long checkpoint_us; // time of the next checkpoint
+	long long begin_us; // of the search phase
+	long long elapsed_ms; // of the previous runs of a resumed search
+	size_t *best; // solution of the incumbent, only kept for checkpoints
+	size_t stop_depth; // depth of the node that checkLimits() stopped
+	const size_t *resume; // facility per depth of the path of a resumed search
+	size_t resume_len;
+	int resuming; // the current node is on the resumed path
+	// transposition table of this thread, NULL if disabled
+	table_entry_st *table;
+	size_t table_mask; // buckets - 1
+	unsigned long long hash; // of the facility states at the entry of the current node
+	size_t table_depth; // deepest probed node, the many small subtrees below do not pay for the probes
+	size_t num_customers;
+	size_t num_facilities;
+	int kernel_width; // facilities of the specialized search kernel, 0 for branch()
+	cflp_instance *instance;
+	facility_tuple_st **tails; // per depth the facilities beyond the nearest list of the current node
+	int node; // NUMA node the thread is pinned to, -1 if not pinned
+	int discrepancy_cut; // the current limited discrepancy pass skipped a subtree
+	// randomized restarts, a run stops after restart_limit nodes (0 for no limit)
+	unsigned long long restart_limit;
+	unsigned long long restart_nodes; // of the current run
+	int restarting; // the run reached its limit, not a stop of the search
+	int thread; // of a deterministic parallel search, its solutions wait for the end of the epoch; -1 otherwise
+	// pass for the next member of a pool: only solutions distinct from its members, NULL otherwise
+	const cflp_pool *exclude;
+	size_t *mismatches; // per member the customers of the path assigned to another facility than in the member
+} bnb_search_st;
+
+// copy of the customers and nearest lists for the threads of a parallel search on one NUMA node
+typedef struct
+{
+	int node; // -1 for a copy that is not bound to a node
+	customer_st *customers;
+	facility_tuple_st *nearest;
+	customer_st *begin;
+	facility_tuple_st **guide; // the warm start guide moved into the copy, NULL without guide
+} replica_st;
+
+void bnb_options_init(bnb_options *options)
+{
+	options->on_solution = NULL;
+	options->on_lower_bound = NULL;
+	options->cancel = NULL;
+	options->tolerance_abs = 0;
+	options->tolerance_rel = 0.0;
+	options->target = CFLP_VAL_INVALID;
+	options->time_limit_ms = 0;
+	options->warm_start = NULL;
+	options->warm_start_branching = 0;
+	options->lower_bound = CFLP_VAL_INVALID;
+	options->threads = 1;
+	options->checkpoint_path = NULL;
+	options->checkpoint_interval_ms = 60000;
+	options->resume = NULL;
+	options->table_mb = 0;
+	options->nearest_len = 0;
+	options->placement = CFLP_PLACEMENT_LOCAL;
+	options->cache_path = NULL;
+	options->strategy = BNB_STRATEGY_DEPTH_FIRST;
+	options->beam_width = 64;
+	options->restart_nodes = 0;
+	options->restart_seed = 1;
+	options->pool = NULL;
+	options->deterministic = 0;
+	options->stats = NULL;
+}
+
+void stopSearch(bnb_search_st *search, bnb_status status)
+{
+	bnb_status expected = BNB_COMPLETE;
+	__atomic_compare_exchange_n(&search->shared->stop, &expected, status, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+	search->stop = __atomic_load_n(&search->shared->stop, __ATOMIC_RELAXED);
+}
+
+void checkLimits(bnb_search_st *search)
+{
+	search->limit_countdown = 4096;
+	if (search->options->cancel != NULL && __atomic_load_n(search->options->cancel, __ATOMIC_RELAXED))
+	{
+		stopSearch(search, BNB_STOPPED);
+	}
+	if (search->deadline_us != 0 && cflp_stats_now_us() >= search->deadline_us)
+	{
+		stopSearch(search, BNB_STOPPED);
+	}
+	// pick up the solutions and the stop of the other threads
+	search->stop = __atomic_load_n(&search->shared->stop, __ATOMIC_RELAXED);
+	if (search->thread < 0) // the bound of a deterministic search changes only between the epochs
+	{
+		search->upper_bound_inc = __atomic_load_n(&search->shared->upper_bound_inc, __ATOMIC_RELAXED);
+	}
+	if (search->restart_limit != 0 && !search->stop && (search->restart_nodes += 4096) >= search->restart_limit)
+	{
+		search->stop = BNB_STOPPED; // only this run
+		search->restarting = 1;
+	}
+}
+
+void reportLowerBound(void *context, const bnb_options *options, cflp_val lower_bound)
+{
+	if (options->on_lower_bound != NULL)
+	{
+		options->on_lower_bound(context, lower_bound);
+	}
+}
+
+// the tolerance at the given costs
+cflp_val toleranceSlack(bnb_search_st *search, cflp_val cost)
+{
+	cflp_val slack = (cflp_val) (search->tolerance_rel * cost);
+	return slack < search->tolerance_abs ? search->tolerance_abs : slack;
+}
+
+// orders solutions of equal costs, so the deterministic search publishes the same one
+int compareAssignments(const size_t *a, const size_t *b, size_t length)
+{
+	for (size_t i = 0; i < length; i++)
+	{
+		if (a[i] != b[i])
+		{
+			return a[i] < b[i] ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+// keeps the best solution of the thread in the current epoch, only the own subproblem sees its bound
+void improveEpochBest(bnb_search_st *search, cflp_val cost)
+{
+	bnb_shared_st *shared = search->shared;
+	cflp_val *best_cost = &shared->epoch_costs[search->thread];
+	size_t *best = shared->epoch_solutions + (size_t) search->thread * search->solution_len;
+	if (cost < *best_cost || (cost == *best_cost && compareAssignments(search->solution, best, search->solution_len) < 0))
+	{
+		*best_cost = cost;
+		memcpy(best, search->solution, sizeof(size_t) * search->solution_len);
+	}
+	cflp_val slack = toleranceSlack(search, cost);
+	if (cost - 1 - slack < search->upper_bound_inc)
+	{
+		search->upper_bound_inc = cost - 1 - slack;
+	}
+	if (search->target != CFLP_VAL_INVALID && cost <= search->target)
+	{
+		search->stop = BNB_TARGET_REACHED; // the subproblem, the search stops at the end of the epoch
+	}
+}
+
+void improveUpperBound(bnb_search_st *search, cflp_val cost)
+{
+	bnb_shared_st *shared = search->shared;
+	if (search->thread >= 0)
+	{
+		improveEpochBest(search, cost);
+		return;
+	}
+	if (search->exclude != NULL && !cflp_pool_distinct(search->exclude, search->solution))
+	{
+		return; // a heuristic solution too close to a member
+	}
+	pthread_mutex_lock(&shared->mutex);
+	if (cost < shared->incumbent) // another thread may have found a better solution meanwhile
+	{
+		cflp_val slack = toleranceSlack(search, cost);
+		shared->incumbent = cost;
+		if (search->best != NULL)
+		{
+			memcpy(search->best, search->solution, sizeof(size_t) * search->solution_len);
+		}
+		__atomic_store_n(&shared->upper_bound_inc, cost - 1 - slack, __ATOMIC_RELAXED);
+		CFLP_STATS_INCUMBENT(search->stats, cost);
+		if (search->options->on_solution != NULL)
+		{
+			search->options->on_solution(search->context, cost, search->solution, search->solution_len);
+		}
+		if (search->target != CFLP_VAL_INVALID && cost <= search->target)
+		{
+			stopSearch(search, BNB_TARGET_REACHED);
+		}
+		else if (search->options->lower_bound != CFLP_VAL_INVALID && cost - slack <= search->options->lower_bound)
+		{
+			shared->proven = 1;
+			stopSearch(search, BNB_STOPPED);
+		}
+	}
+	search->upper_bound_inc = __atomic_load_n(&shared->upper_bound_inc, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&shared->mutex);
+}
+
+int compareFacilityTuplesAsc(const void *a, const void *b)
+{
+	cflp_val x = ((const facility_tuple_st *) a)->key;
+	cflp_val y = ((const facility_tuple_st *) b)->key;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// The facilities of a customer beyond its nearest list that the bound admits, linked in ascending order;
+// NULL if none. They cost at least the last entry of the list, so most nodes never scan them.
+facility_tuple_st *expandTail(bnb_search_st *search, customer_st *customer, cflp_val cost)
+{
+	cflp_val limit = search->upper_bound_inc - cost - customer->lower; // highest key that can be searched
+	cflp_val excluded = CFLP_VAL_MAX; // smallest key of a pruned facility
+	facility_tuple_st *last = customer->last;
+	facility_tuple_st *tail = NULL;
+	size_t num_tail = 0;
+	if (last->key <= limit)
+	{
+		cflp_instance *instance = search->instance;
+		if (search->tails[customer->depth] == NULL)
+		{
+			search->tails[customer->depth] = (facility_tuple_st *) malloc(sizeof(facility_tuple_st) * instance->num_facilities);
+		}
+		tail = search->tails[customer->depth];
+		for (size_t k = 0; k < instance->num_facilities; k++)
+		{
+			cflp_val key = CFLP_INSTANCE_DISTANCE(instance, k, customer->num) * instance->distance_costs;
+			if (key < last->key)
+			{
+				continue;
+			}
+			if (key == last->key) // equal keys may be on both sides of the end of the list
+			{
+				facility_tuple_st *facilityTuple = customer->nearest;
+				while (facilityTuple != last && facilityTuple->facility != k)
+				{
+					facilityTuple = facilityTuple->next;
+				}
+				if (facilityTuple->facility == k)
+				{
+					continue;
+				}
+			}
+			if (key > limit)
+			{
+				excluded = key < excluded ? key : excluded;
+				continue;
+			}
+			tail[num_tail].key = key;
+			tail[num_tail].facility = k;
+			num_tail++;
+		}
+	}
+	else
+	{
+		excluded = last->key;
+	}
+	if (excluded != CFLP_VAL_MAX && cost + excluded + customer->lower < search->pruned_lower)
+	{
+		search->pruned_lower = cost + excluded + customer->lower;
+	}
+	if (num_tail == 0)
+	{
+		return NULL;
+	}
+	qsort(tail, num_tail, sizeof(facility_tuple_st), compareFacilityTuplesAsc);
+	for (size_t i = 0; i + 1 < num_tail; i++)
+	{
+		tail[i].next = &tail[i + 1];
+	}
+	tail[num_tail - 1].next = NULL;
+	return tail;
+}
+
+// next entry of the loop over the facilities of a customer, continues behind a partial nearest list
+#define NEXT_FACILITY(search, customer, cost, facilityTuple) \
+	((facilityTuple) != (customer)->last ? (facilityTuple)->next : expandTail(search, customer, cost))
+
+// Zobrist key of a facility state, unused facilities contribute nothing
+unsigned long long stateKey(size_t facility, size_t user, cflp_val bandwidth)
+{
+	if (user == 0)
+	{
+		return 0;
+	}
+	unsigned long long x = facility * 0x9E3779B97F4A7C15ULL ^ (unsigned long long) user << 32 ^ (unsigned int) bandwidth;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL; // splitmix64 finalizer
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+// hash of the facility states after adding a customer with the bandwidth to the facility
+unsigned long long addedHash(unsigned long long hash, facility_st *facility, cflp_val bandwidth)
+{
+	return hash ^ stateKey(facility->num, facility->user, facility->bandwidth)
+		^ stateKey(facility->num, facility->user + 1, facility->bandwidth + bandwidth);
+}
+
+unsigned long long facilitiesHash(facility_st *facilities, size_t num_facilities)
+{
+	unsigned long long hash = 0;
+	for (size_t i = 0; i < num_facilities; i++)
+	{
+		hash ^= stateKey(facilities[i].num, facilities[i].user, facilities[i].bandwidth);
+	}
+	return hash;
+}
+
+table_entry_st *createTable(size_t bytes, size_t *mask)
+{
+	size_t buckets = 1;
+	while (buckets * 2 * TABLE_BUCKET * sizeof(table_entry_st) <= bytes)
+	{
+		buckets *= 2;
+	}
+	*mask = buckets - 1;
+	return (table_entry_st *) calloc(buckets * TABLE_BUCKET, sizeof(table_entry_st));
+}
+
+// Two prefixes of the same depth that leave the facilities in the same state have the same subtree,
+// so the costlier one can not lead to a better solution. Returns 1 if the node is pruned, otherwise
+// its costs are stored.
+int probeTable(bnb_search_st *search, size_t depth, cflp_val cost)
+{
+	unsigned long long key = search->hash ^ (depth + 1) * 0xC2B2AE3D27D4EB4FULL;
+	table_entry_st *bucket = search->table + (key & search->table_mask) * TABLE_BUCKET;
+	for (int i = 0; i < TABLE_BUCKET; i++)
+	{
+		if (bucket[i].key == key && bucket[i].height != 0)
+		{
+			if (bucket[i].cost <= cost)
+			{
+				CFLP_STATS_COUNT(search->stats, table_hits);
+				return 1;
+			}
+			bucket[i].cost = cost;
+			CFLP_STATS_COUNT(search->stats, table_misses);
+			return 0;
+		}
+	}
+	CFLP_STATS_COUNT(search->stats, table_misses);
+	unsigned int height = (unsigned int) (search->num_customers - depth);
+	table_entry_st *entry = height >= bucket[0].height ? &bucket[0] : &bucket[1];
+	if (entry->height != 0)
+	{
+		CFLP_STATS_COUNT(search->stats, table_replaced);
+	}
+	entry->key = key;
+	entry->cost = cost;
+	entry->height = height;
+	return 0;
+}
+
+// state of the search at the entry of a node of the given depth, the facilities of its path are in the solution
+void fillCheckpoint(bnb_search_st *search, cflp_checkpoint *checkpoint, size_t depth)
+{
+	checkpoint->instance_hash = search->instance_hash;
+	checkpoint->done = 0;
+	checkpoint->incumbent = search->shared->incumbent != CFLP_VAL_MAX ? search->shared->incumbent : CFLP_VAL_INVALID;
+	memcpy(checkpoint->solution, search->best, sizeof(size_t) * search->solution_len);
+	checkpoint->pruned_lower = search->pruned_lower;
+	checkpoint->path_len = depth;
+	customer_st *customer = search->begin;
+	for (size_t i = 0; i < depth; i++, customer = customer->next)
+	{
+		checkpoint->path[i] = search->solution[customer->num];
+	}
+	checkpoint->elapsed_ms = search->elapsed_ms + (cflp_stats_now_us() - search->begin_us) / 1000;
+#ifdef CFLP_STATS
+	checkpoint->nodes = search->stats->nodes;
+	checkpoint->pruned_bound = search->stats->pruned_bound;
+	checkpoint->pruned_capacity = search->stats->pruned_capacity;
+	checkpoint->pruned_theo = search->stats->pruned_theo;
+#endif
+}
+
+// hands a snapshot to the writer thread if the interval passed and the previous one is written
+void checkpointSearch(bnb_search_st *search, size_t depth)
+{
+	if (cflp_stats_now_us() < search->checkpoint_us)
+	{
+		return;
+	}
+	cflp_checkpoint *checkpoint = cflp_checkpoint_writer_begin(search->checkpoint);
+	if (checkpoint != NULL)
+	{
+		fillCheckpoint(search, checkpoint, depth);
+		cflp_checkpoint_writer_commit(search->checkpoint);
+		search->checkpoint_us = cflp_stats_now_us() + search->options->checkpoint_interval_ms * 1000;
+	}
+}
+
+// the nearest list entry of the resumed path at the customer, NULL if the path ends before it
+facility_tuple_st *resumeTuple(bnb_search_st *search, customer_st *customer)
+{
+	if (customer->depth >= search->resume_len)
+	{
+		return NULL;
+	}
+	facility_tuple_st *facilityTuple = customer->nearest;
+	while (facilityTuple != NULL && facilityTuple->facility != search->resume[customer->depth])
+	{
+		facilityTuple = facilityTuple->next;
+	}
+	return facilityTuple;
+}
+
+// Counts the customer for the members of a pool pass, returns 0 (with the counts unchanged) if a member
+// stays closer than its min_distance whatever the customers after it get.
+int enterDistinct(bnb_search_st *search, customer_st *customer, size_t facility)
+{
+	size_t num_members = cflp_pool_size(search->exclude);
+	size_t remaining = search->num_customers - 1 - customer->depth;
+	size_t min_distance = cflp_pool_min_distance(search->exclude);
+	int distinct = 1;
+	for (size_t m = 0; m < num_members; m++)
+	{
+		search->mismatches[m] += cflp_pool_solution(search->exclude, m)[customer->num] != facility;
+		distinct &= search->mismatches[m] + remaining >= min_distance;
+	}
+	if (!distinct)
+	{
+		for (size_t m = 0; m < num_members; m++)
+		{
+			search->mismatches[m] -= cflp_pool_solution(search->exclude, m)[customer->num] != facility;
+		}
+	}
+	return distinct;
+}
+
+void leaveDistinct(bnb_search_st *search, customer_st *customer, size_t facility)
+{
+	for (size_t m = 0; m < cflp_pool_size(search->exclude); m++)
+	{
+		search->mismatches[m] -= cflp_pool_solution(search->exclude, m)[customer->num] != facility;
+	}
+}
+
+void branch(bnb_search_st *search, customer_st *customer, cflp_val cost)
+{
+	CFLP_STATS_NODE(search->stats, customer->depth);
+	if (--search->limit_countdown == 0) {
+		checkLimits(search);
+		if (search->stop) {
+			search->stop_depth = customer->depth;
+			return;
+		}
+		if (search->checkpoint != NULL) {
+			checkpointSearch(search, customer->depth);
+		}
+	}
+	// a resumed search skips the subtrees left of the path, they were searched before the checkpoint
+	facility_tuple_st *first = customer->nearest;
+	facility_tuple_st *resumed = NULL;
+	if (search->resuming) {
+		search->resuming = 0;
+		resumed = resumeTuple(search, customer);
+		if (resumed != NULL) {
+			first = resumed;
+		}
+	}
+	unsigned long long hash = search->hash;
+	if (search->table != NULL && customer->depth <= search->table_depth && probeTable(search, customer->depth, cost)) {
+		return;
+	}
+	facility_tuple_st *guided = search->guide != NULL ? search->guide[customer->num] : NULL;
+	if (guided != NULL) { // warm start facility first, the loop handles it if it is pruned
+		facility_st *facility = &search->facilities[guided->facility];
+		cflp_val newCost = cost + recentCost(facility) + guided->key;
+		if (newCost + customer->lower <= search->upper_bound_inc && canAddUser(facility, search->max_bandwidth, customer->key)) {
+			search->solution[customer->num] = facility->num;
+			if (search->table != NULL && customer->depth < search->table_depth) {
+				search->hash = addedHash(hash, facility, customer->key);
+			}
+			addUser(facility, customer->key);
+			if (customer->next == NULL) {
+				improveUpperBound(search, newCost);
+			}
+			else {
+				branch(search, customer->next, newCost);
+			}
+			removeUser(facility, customer->key);
+			if (search->stop) {
+				return;
+			}
+		}
+		else {
+			guided = NULL;
+		}
+	}
+	for (facility_tuple_st *facilityTuple = first;
+		 facilityTuple != NULL; facilityTuple = NEXT_FACILITY(search, customer, cost, facilityTuple)) {
+		if (facilityTuple == guided) {
+			continue;
+		}
+		facility_st *facility = &search->facilities[facilityTuple->facility];
+		cflp_val newCost = cost + recentCost(facility) + facilityTuple->key;
+		if (newCost + customer->lower <= search->upper_bound_inc) { // L < U Bounding
+			cflp_val bandwidth = customer->key;
+			if (search->exclude != NULL && !enterDistinct(search, customer, facility->num)) {
+				continue; // every solution below is too close to a member of the pool
+			}
+			if (canAddUser(facility, search->max_bandwidth, bandwidth)) { // check if valid solution
+				search->solution[customer->num] = facility->num;
+				if (search->table != NULL && customer->depth < search->table_depth) {
+					search->hash = addedHash(hash, facility, bandwidth);
+				}
 				addUser(facility, bandwidth);
 				if (customer->next == NULL) {
-					*UpperBoundInclusive = newCost - 1;
-					bnb_set_solution(context, newCost, solution, solution_len);
+					improveUpperBound(search, newCost);
 				}
 				else {
-					customer->next->cost = newCost;
-					branch(context, customer->next, solution, UpperBoundInclusive, maxBandwidth, solution_len);
+					search->resuming = facilityTuple == resumed;
+					branch(search, customer->next, newCost);
 				}
 				removeUser(facility, bandwidth);
+				if (search->exclude != NULL) {
+					leaveDistinct(search, customer, facility->num);
+				}
+				if (search->stop) {
+					return;
+				}
+			}
+			else {
+				if (search->exclude != NULL) {
+					leaveDistinct(search, customer, facility->num);
+				}
+				CFLP_STATS_COUNT(search->stats, pruned_capacity);
+			}
+		}
+		else {
+			if (newCost + customer->lower < search->pruned_lower) {
+				search->pruned_lower = newCost + customer->lower;
 			}
+			if (facility->user > 0) { // Theo's improvement
+				CFLP_STATS_COUNT(search->stats, pruned_theo);
+				return;
+			}
+			CFLP_STATS_COUNT(search->stats, pruned_bound);
 		}
-		else if (facility->user > 0) { // Theo's improvement
+	}
+}
+
+// Search kernels for instances with at most WIDTH facilities: the open facilities are a bitmask and the
+// remaining capacities are packed in fixed-size arrays, so the opening costs and the capacity test need
+// neither a facility_st nor a branch. Same search as branch() without warm start guide, resume and
+// transposition table.
+#define DEFINE_KERNEL(WIDTH) \
+typedef struct \
+{ \
+	unsigned long long open; /* facilities with customers */ \
+	cflp_val slots[WIDTH]; /* customers left, 0 beyond the facilities of the instance */ \
+	cflp_val residual[WIDTH]; /* bandwidth left */ \
+	cflp_val opening_costs[WIDTH]; \
+} kernel##WIDTH##_st; \
+\
+void branchKernel##WIDTH(bnb_search_st *search, kernel##WIDTH##_st *state, customer_st *customer, cflp_val cost) \
+{ \
+	CFLP_STATS_NODE(search->stats, customer->depth); \
+	if (--search->limit_countdown == 0) { \
+		checkLimits(search); \
+		if (search->stop) { \
+			search->stop_depth = customer->depth; \
+			return; \
+		} \
+		if (search->checkpoint != NULL) { \
+			checkpointSearch(search, customer->depth); \
+		} \
+	} \
+	cflp_val bandwidth = customer->key; \
+	for (facility_tuple_st *facilityTuple = customer->nearest; \
+		 facilityTuple != NULL; facilityTuple = NEXT_FACILITY(search, customer, cost, facilityTuple)) { \
+		size_t f = facilityTuple->facility; \
+		unsigned long long bit = 1ULL << f; \
+		cflp_val newCost = cost + ((state->open & bit) ? 0 : state->opening_costs[f]) + facilityTuple->key; \
+		if (newCost + customer->lower <= search->upper_bound_inc) { \
+			if ((state->slots[f] > 0) & (state->residual[f] >= bandwidth)) { \
+				search->solution[customer->num] = f; \
+				unsigned long long open = state->open; \
+				state->open |= bit; \
+				state->slots[f]--; \
+				state->residual[f] -= bandwidth; \
+				if (customer->next == NULL) { \
+					improveUpperBound(search, newCost); \
+				} \
+				else { \
+					branchKernel##WIDTH(search, state, customer->next, newCost); \
+				} \
+				state->open = open; \
+				state->slots[f]++; \
+				state->residual[f] += bandwidth; \
+				if (search->stop) { \
+					return; \
+				} \
+			} \
+			else { \
+				CFLP_STATS_COUNT(search->stats, pruned_capacity); \
+			} \
+		} \
+		else { \
+			if (newCost + customer->lower < search->pruned_lower) { \
+				search->pruned_lower = newCost + customer->lower; \
+			} \
+			if (state->open & bit) { /* Theo's improvement */ \
+				CFLP_STATS_COUNT(search->stats, pruned_theo); \
+				return; \
+			} \
+			CFLP_STATS_COUNT(search->stats, pruned_bound); \
+		} \
+	} \
+} \
+\
+void runKernel##WIDTH(bnb_search_st *search, customer_st *customer, cflp_val cost) \
+{ \
+	kernel##WIDTH##_st state; \
+	memset(&state, 0, sizeof(state)); \
+	for (size_t f = 0; f < search->num_facilities; f++) { \
+		facility_st *facility = &search->facilities[f]; \
+		if (facility->user > 0) { \
+			state.open |= 1ULL << f; \
+		} \
+		size_t slots = facility->max_user - facility->user; \
+		state.slots[f] = slots < (size_t) CFLP_VAL_MAX ? (cflp_val) slots : CFLP_VAL_MAX; \
+		state.residual[f] = search->max_bandwidth - facility->bandwidth; \
+		state.opening_costs[f] = facility->opening_costs; \
+	} \
+	branchKernel##WIDTH(search, &state, customer, cost); \
+}
+
+DEFINE_KERNEL(16)
+DEFINE_KERNEL(32)
+DEFINE_KERNEL(64)
+
+// searches the subtree of the customer with the facilities in their current state
+void searchSubtree(bnb_search_st *search, customer_st *customer, cflp_val cost)
+{
+	switch (search->kernel_width)
+	{
+	case 16:
+		runKernel16(search, customer, cost);
+		break;
+	case 32:
+		runKernel32(search, customer, cost);
+		break;
+	case 64:
+		runKernel64(search, customer, cost);
+		break;
+	default:
+		branch(search, customer, cost);
+	}
+}
+
+// Limited discrepancy search: like branch(), but after the first facility with room of each customer
+// every further facility uses up one of the discrepancies.
+void branchDiscrepancies(bnb_search_st *search, customer_st *customer, cflp_val cost, size_t discrepancies)
+{
+	CFLP_STATS_NODE(search->stats, customer->depth);
+	if (--search->limit_countdown == 0) {
+		checkLimits(search);
+		if (search->stop) {
 			return;
 		}
 	}
+	int taken = 0;
+	for (facility_tuple_st *facilityTuple = customer->nearest;
+		 facilityTuple != NULL; facilityTuple = NEXT_FACILITY(search, customer, cost, facilityTuple)) {
+		facility_st *facility = &search->facilities[facilityTuple->facility];
+		cflp_val newCost = cost + recentCost(facility) + facilityTuple->key;
+		if (newCost + customer->lower <= search->upper_bound_inc) {
+			cflp_val bandwidth = customer->key;
+			if (canAddUser(facility, search->max_bandwidth, bandwidth)) {
+				if (taken && discrepancies == 0) {
+					search->discrepancy_cut = 1;
+					return;
+				}
+				search->solution[customer->num] = facility->num;
+				addUser(facility, bandwidth);
+				if (customer->next == NULL) {
+					improveUpperBound(search, newCost);
+				}
+				else {
+					branchDiscrepancies(search, customer->next, newCost, discrepancies - taken);
+				}
+				removeUser(facility, bandwidth);
+				if (search->stop) {
+					return;
+				}
+				taken = 1;
+			}
+			else {
+				CFLP_STATS_COUNT(search->stats, pruned_capacity);
+			}
+		}
+		else {
+			if (newCost + customer->lower < search->pruned_lower) {
+				search->pruned_lower = newCost + customer->lower;
+			}
+			if (facility->user > 0) { // Theo's improvement
+				CFLP_STATS_COUNT(search->stats, pruned_theo);
+				return;
+			}
+			CFLP_STATS_COUNT(search->stats, pruned_bound);
+		}
+	}
 }
 
-void bnb_run(void *context, cflp_instance *instance)
+// passes with 0, 1, 2, ... discrepancies until a pass skips nothing, that pass is a complete search
+void discrepancySearch(bnb_search_st *search)
 {
-	// calculateBestCustomers
-	customer_st *customersBandwidth = (customer_st *) malloc(sizeof(customer_st) * instance->num_customers);
-	facility_st *facilities = (facility_st *) malloc(sizeof(facility_st) * instance->num_facilities);
-	for (size_t k = 0; k < instance->num_facilities; k++)
+	for (size_t discrepancies = 0; !search->stop; discrepancies++)
 	{
-		facilities[k].bandwidth = 0;
-		facilities[k].max_user = instance->fac_max_customers[k];
-		facilities[k].num = k;
-		facilities[k].opening_costs = instance->fac_opening_costs[k];
-		facilities[k].user = 0;
+		search->discrepancy_cut = 0;
+		search->pruned_lower = CFLP_VAL_MAX;
+		branchDiscrepancies(search, search->begin, 0, discrepancies);
+		if (!search->discrepancy_cut)
+		{
+			break;
+		}
 	}
-	for (size_t i = 0; i < instance->num_customers; i++)
+}
+
+// child of the beam search: a facility for the customer of the level added to a beam entry
+typedef struct
+{
+	cflp_val key; // costs plus the lower bound of the remaining customers
+	cflp_val cost;
+	size_t entry;
+	size_t facility;
+} beam_candidate_st;
+
+// the heap keeps the width cheapest children with the most expensive one on top
+void siftBeamCandidate(beam_candidate_st *heap, size_t num, size_t i)
+{
+	for (;;)
 	{
-		facility_tuple_st *nearest = (facility_tuple_st *) malloc(sizeof(facility_tuple_st) * instance->num_facilities);
-		for (size_t k = 0; k < instance->num_facilities; k++)
+		size_t largest = i;
+		size_t left = 2 * i + 1;
+		size_t right = left + 1;
+		if (left < num && heap[left].key > heap[largest].key)
 		{
-			nearest[k].key = instance->distances[CFLP_INSTANCE_DISTANCE_INDEX(k, i, instance->num_facilities, instance->num_customers)] * instance->distance_costs;
-			nearest[k].value = &facilities[k];
-			nearest[k].next = NULL;
+			largest = left;
 		}
-		merge_sort_asc(nearest, instance->num_facilities);
-		facility_tuple_st *ptr = &nearest[0];
-		for (size_t k = 1; k < instance->num_facilities; k++)
+		if (right < num && heap[right].key > heap[largest].key)
 		{
-			ptr->next = &nearest[k];
-			ptr = ptr->next;
+			largest = right;
 		}
-		customersBandwidth[i].key = instance->cus_bandwidths[i];
-		customersBandwidth[i].num = i;
-		customersBandwidth[i].nearest = nearest;
-		customersBandwidth[i].lower = 0;
-		customersBandwidth[i].next = NULL;
-		customersBandwidth[i].cost = 0;
-	}
-	// TODO: sort customersBandwidth here
-	customer_st *begin = &customersBandwidth[0];
-	customer_st *ptr = begin;
-	for (size_t i = 1; i < instance->num_customers; i++) {
-		ptr->next = &customersBandwidth[i];
-		ptr = ptr->next;
+		if (largest == i)
+		{
+			return;
+		}
+		beam_candidate_st swap = heap[i];
+		heap[i] = heap[largest];
+		heap[largest] = swap;
+		i = largest;
 	}
-	// calculateLowerBound
-	cflp_val cost = 0;
-	customersBandwidth[instance->num_customers - 1].lower = cost;
-	for (size_t i = instance->num_customers - 1; i > 0; i--)
+}
+
+// Beam search: assigns the customers level by level and keeps only the width cheapest partial
+// solutions (costs plus lower bound) of each level. The dropped subtrees are not bounded, so the
+// pass only improves the incumbent; each entry has its own copy of the facilities.
+void beamSearch(bnb_search_st *search, size_t width)
+{
+	size_t num_facilities = search->num_facilities;
+	size_t num_customers = search->num_customers;
+	if (width == 0 || num_customers == 0)
 	{
-		customer_st *customer = &customersBandwidth[i];
-		cflp_val minDistance = customer->nearest->key;
-		cost += minDistance;
-		customersBandwidth[i - 1].lower = cost;
+		return;
 	}
-	// TODO: use Upper Bound Heuristic here
+	facility_st *states = (facility_st *) malloc(sizeof(facility_st) * num_facilities * width);
+	facility_st *next = (facility_st *) malloc(sizeof(facility_st) * num_facilities * width);
+	cflp_val *costs = (cflp_val *) malloc(sizeof(cflp_val) * width);
+	beam_candidate_st *heap = (beam_candidate_st *) malloc(sizeof(beam_candidate_st) * width);
+	// per level and entry the parent entry and the facility, to walk back to the root
+	size_t *parents = (size_t *) malloc(sizeof(size_t) * width * num_customers);
+	size_t *chosen = (size_t *) malloc(sizeof(size_t) * width * num_customers);
+	customer_st **path = (customer_st **) malloc(sizeof(customer_st *) * num_customers);
+	cflp_val pruned_lower = search->pruned_lower;
 
-	size_t* solution = (size_t*)malloc(sizeof(size_t)* instance->num_customers);
-	
-	cflp_val upper_bound_inc = CFLP_VAL_MAX;
-	branch(context, begin, solution, &upper_bound_inc, instance->max_bandwith, instance->num_customers);
-	
-	free(solution);
-	solution = NULL;
+	memcpy(states, search->facilities, sizeof(facility_st) * num_facilities);
+	costs[0] = 0;
+	size_t count = 1;
+	size_t depth = 0;
+	for (customer_st *customer = search->begin; customer != NULL && count > 0; customer = customer->next, depth++)
+	{
+		checkLimits(search);
+		if (search->stop)
+		{
+			break;
+		}
+		path[depth] = customer;
+		size_t num = 0;
+		for (size_t e = 0; e < count; e++)
+		{
+			facility_st *facilities = states + e * num_facilities;
+			for (facility_tuple_st *facilityTuple = customer->nearest;
+				 facilityTuple != NULL; facilityTuple = NEXT_FACILITY(search, customer, costs[e], facilityTuple))
+			{
+				facility_st *facility = &facilities[facilityTuple->facility];
+				cflp_val newCost = costs[e] + recentCost(facility) + facilityTuple->key;
+				cflp_val key = newCost + customer->lower;
+				if (key > search->upper_bound_inc || (num == width && key >= heap[0].key))
+				{
+					if (facility->user > 0) // the facilities further down the list cost at least as much
+					{
+						break;
+					}
+					continue;
+				}
+				if (!canAddUser(facility, search->max_bandwidth, customer->key))
+				{
+					continue;
+				}
+				CFLP_STATS_NODE(search->stats, customer->depth);
+				beam_candidate_st candidate = { key, newCost, e, facilityTuple->facility };
+				if (num < width)
+				{
+					// sift up
+					size_t i = num++;
+					heap[i] = candidate;
+					while (i > 0 && heap[(i - 1) / 2].key < heap[i].key)
+					{
+						beam_candidate_st swap = heap[i];
+						heap[i] = heap[(i - 1) / 2];
+						heap[(i - 1) / 2] = swap;
+						i = (i - 1) / 2;
+					}
+				}
+				else
+				{
+					heap[0] = candidate;
+					siftBeamCandidate(heap, num, 0);
+				}
+			}
+		}
+		for (size_t i = 0; i < num; i++)
+		{
+			memcpy(next + i * num_facilities, states + heap[i].entry * num_facilities, sizeof(facility_st) * num_facilities);
+			addUser(&next[i * num_facilities + heap[i].facility], customer->key);
+			costs[i] = heap[i].cost;
+			parents[depth * width + i] = heap[i].entry;
+			chosen[depth * width + i] = heap[i].facility;
+		}
+		facility_st *swap = states;
+		states = next;
+		next = swap;
+		count = num;
+	}
+	if (depth == num_customers && count > 0)
+	{
+		size_t best = 0;
+		for (size_t i = 1; i < count; i++)
+		{
+			best = costs[i] < costs[best] ? i : best;
+		}
+		cflp_val cost = costs[best];
+		for (size_t d = num_customers; d-- > 0;)
+		{
+			search->solution[path[d]->num] = chosen[d * width + best];
+			best = parents[d * width + best];
+		}
+		if (cost <= search->upper_bound_inc)
+		{
+			improveUpperBound(search, cost);
+		}
+	}
+	search->pruned_lower = pruned_lower;
+	free(path);
+	free(chosen);
+	free(parents);
+	free(heap);
+	free(costs);
+	free(next);
+	free(states);
+}
+
+// collects the nodes at the given depth that survive the bounding in the order of branch() as subproblems
+void collectPrefixes(bnb_search_st *search, customer_st *customer, cflp_val cost, size_t depth)
+{
+	bnb_shared_st *shared = search->shared;
+	if (customer->depth == depth)
+	{
+		if (shared->prefix_count == shared->prefix_capacity)
+		{
+			shared->prefix_capacity = shared->prefix_capacity * 2 + 16;
+			shared->prefixes = (size_t *) realloc(shared->prefixes, sizeof(size_t) * shared->prefix_capacity * (depth + 1));
+			shared->prefix_costs = (cflp_val *) realloc(shared->prefix_costs, sizeof(cflp_val) * shared->prefix_capacity);
+		}
+		size_t *prefix = shared->prefixes + shared->prefix_count * (depth + 1);
+		for (customer_st *ptr = search->begin; ptr != customer; ptr = ptr->next)
+		{
+			*prefix++ = search->solution[ptr->num];
+		}
+		shared->prefix_costs[shared->prefix_count++] = cost;
+		return;
+	}
+	for (facility_tuple_st *facilityTuple = customer->nearest;
+		 facilityTuple != NULL; facilityTuple = NEXT_FACILITY(search, customer, cost, facilityTuple)) {
+		facility_st *facility = &search->facilities[facilityTuple->facility];
+		cflp_val newCost = cost + recentCost(facility) + facilityTuple->key;
+		if (newCost + customer->lower <= search->upper_bound_inc) {
+			cflp_val bandwidth = customer->key;
+			if (canAddUser(facility, search->max_bandwidth, bandwidth)) {
+				search->solution[customer->num] = facility->num;
+				addUser(facility, bandwidth);
+				collectPrefixes(search, customer->next, newCost, depth);
+				removeUser(facility, bandwidth);
+			}
+		}
+		else {
+			if (newCost + customer->lower < search->pruned_lower) {
+				search->pruned_lower = newCost + customer->lower;
+			}
+			if (facility->user > 0) { // Theo's improvement
+				return;
+			}
+		}
+	}
+}
+
+// splits the search into at least min_count subproblems (if the tree is deep enough)
+void splitSearch(bnb_search_st *search, size_t num_customers, size_t min_count)
+{
+	bnb_shared_st *shared = search->shared;
+	shared->prefix_depth = 0;
+	shared->prefix_count = 1; // the root
+	while (shared->prefix_count > 0 && shared->prefix_count < min_count && shared->prefix_depth + 1 < num_customers)
+	{
+		shared->prefix_depth++;
+		shared->prefix_count = 0;
+		shared->prefix_capacity = 0; // the prefixes got longer
+		collectPrefixes(search, search->begin, 0, shared->prefix_depth);
+	}
+	if (shared->prefix_depth == 0)
+	{
+		shared->prefixes = (size_t *) realloc(shared->prefixes, sizeof(size_t));
+		shared->prefix_costs = (cflp_val *) realloc(shared->prefix_costs, sizeof(cflp_val));
+		shared->prefix_costs[0] = 0;
+	}
+}
+
+// searches the subproblem with the index, the facilities of its prefix are removed afterwards
+void searchPrefix(bnb_search_st *search, size_t index)
+{
+	bnb_shared_st *shared = search->shared;
+	size_t stride = shared->prefix_depth + 1;
+	customer_st *customer = search->begin;
+	for (size_t i = 0; i < shared->prefix_depth; i++, customer = customer->next)
+	{
+		size_t facility = shared->prefixes[index * stride + i];
+		search->solution[customer->num] = facility;
+		addUser(&search->facilities[facility], customer->key);
+	}
+	checkLimits(search);
+	if (search->table != NULL)
+	{
+		search->hash = facilitiesHash(search->facilities, search->num_facilities);
+	}
+	if (!search->stop)
+	{
+		searchSubtree(search, customer, shared->prefix_costs[index]);
+	}
+	customer = search->begin;
+	for (size_t i = 0; i < shared->prefix_depth; i++, customer = customer->next)
+	{
+		removeUser(&search->facilities[shared->prefixes[index * stride + i]], customer->key);
+	}
+}
+
+void* searchThread(void *param)
+{
+	bnb_search_st *search = (bnb_search_st *) param;
+	bnb_shared_st *shared = search->shared;
+	if (search->node >= 0)
+	{
+		cflp_memory_pin_thread(pthread_self(), search->node);
+	}
+	size_t index;
+	while (!search->stop && (index = __atomic_fetch_add(&shared->prefix_next, 1, __ATOMIC_RELAXED)) < shared->prefix_count)
+	{
+		searchPrefix(search, index);
+	}
+	return NULL;
+}
+
+// the subproblem of the thread in the epoch of a deterministic search, with the bound of the epoch start
+void searchEpoch(bnb_search_st *search, size_t epoch)
+{
+	bnb_shared_st *shared = search->shared;
+	size_t index = epoch * shared->num_threads + search->thread;
+	shared->epoch_costs[search->thread] = CFLP_VAL_MAX;
+	search->stop = __atomic_load_n(&shared->stop, __ATOMIC_RELAXED);
+	search->upper_bound_inc = __atomic_load_n(&shared->upper_bound_inc, __ATOMIC_RELAXED);
+	if (index < shared->prefix_count && !search->stop)
+	{
+		searchPrefix(search, index);
+	}
+}
+
+void* deterministicThread(void *param)
+{
+	bnb_search_st *search = (bnb_search_st *) param;
+	bnb_shared_st *shared = search->shared;
+	if (search->node >= 0)
+	{
+		cflp_memory_pin_thread(pthread_self(), search->node);
+	}
+	size_t epoch = 0;
+	for (;;)
+	{
+#ifdef CFLP_STATS
+		long long wait_us = cflp_stats_now_us();
+#endif
+		pthread_mutex_lock(&shared->mutex);
+		while (shared->epoch == epoch && !shared->epoch_exit)
+		{
+			pthread_cond_wait(&shared->epoch_cond, &shared->mutex);
+		}
+		int exit = shared->epoch_exit;
+		epoch = shared->epoch;
+		pthread_mutex_unlock(&shared->mutex);
+#ifdef CFLP_STATS
+		search->stats->epoch_wait_us += cflp_stats_now_us() - wait_us;
+#endif
+		if (exit)
+		{
+			return NULL;
+		}
+		searchEpoch(search, epoch - 1);
+		pthread_mutex_lock(&shared->mutex);
+		shared->epoch_done++;
+		pthread_cond_broadcast(&shared->epoch_cond);
+		pthread_mutex_unlock(&shared->mutex);
+	}
+}
+
+// Runs the epochs of a deterministic search. The subproblems of threads that could not be started
+// are searched by the calling thread with their own state, so the results do not change.
+void runEpochs(bnb_search_st *search, bnb_search_st *workers, const int *started)
+{
+	bnb_shared_st *shared = search->shared;
+	int threads = shared->num_threads;
+	int num_started = 0;
+	for (int t = 1; t < threads; t++)
+	{
+		num_started += started[t];
+	}
+	size_t num_epochs = (shared->prefix_count + threads - 1) / threads;
+	for (size_t epoch = 0; epoch < num_epochs && !__atomic_load_n(&shared->stop, __ATOMIC_RELAXED); epoch++)
+	{
+		pthread_mutex_lock(&shared->mutex);
+		shared->epoch_done = 0;
+		shared->epoch = epoch + 1;
+		pthread_cond_broadcast(&shared->epoch_cond);
+		pthread_mutex_unlock(&shared->mutex);
+		for (int t = 0; t < threads; t++)
+		{
+			if (t == 0 || !started[t])
+			{
+				searchEpoch(&workers[t], epoch);
+			}
+		}
+#ifdef CFLP_STATS
+		long long wait_us = cflp_stats_now_us();
+#endif
+		pthread_mutex_lock(&shared->mutex);
+		while (shared->epoch_done < num_started)
+		{
+			pthread_cond_wait(&shared->epoch_cond, &shared->mutex);
+		}
+		pthread_mutex_unlock(&shared->mutex);
+#ifdef CFLP_STATS
+		workers[0].stats->epoch_wait_us += cflp_stats_now_us() - wait_us;
+		workers[0].stats->epochs++;
+#endif
+		// the cheapest solution of the epoch, equal costs by the assignment
+		int best = -1;
+		for (int t = 0; t < threads; t++)
+		{
+			cflp_val cost = shared->epoch_costs[t];
+			if (cost != CFLP_VAL_MAX && (best < 0 || cost < shared->epoch_costs[best]
+				|| (cost == shared->epoch_costs[best] && compareAssignments(shared->epoch_solutions + t * search->solution_len,
+					shared->epoch_solutions + best * search->solution_len, search->solution_len) < 0)))
+			{
+				best = t;
+			}
+		}
+		if (best >= 0 && shared->epoch_costs[best] <= search->upper_bound_inc)
+		{
+			memcpy(search->solution, shared->epoch_solutions + best * search->solution_len, sizeof(size_t) * search->solution_len);
+			improveUpperBound(search, shared->epoch_costs[best]);
+		}
+	}
+	pthread_mutex_lock(&shared->mutex);
+	shared->epoch_exit = 1;
+	pthread_cond_broadcast(&shared->epoch_cond);
+	pthread_mutex_unlock(&shared->mutex);
+}
+
+void freeTails(facility_tuple_st **tails, size_t num_customers)
+{
+	if (tails == NULL)
+	{
+		return;
+	}
+	for (size_t i = 0; i < num_customers; i++)
+	{
+		free(tails[i]);
+	}
+	free(tails);
+}
+
+// searches the subproblems with the given number of threads, the calling thread is one of them;
+// with replicas the threads are spread over their nodes and read the copy of their node
+void parallelSearch(bnb_search_st *search, size_t num_facilities, size_t num_customers, int threads,
+					const replica_st *replicas, int num_replicas)
+{
+	splitSearch(search, num_customers, (size_t) threads * 16);
+
+	bnb_search_st *workers = (bnb_search_st *) malloc(sizeof(bnb_search_st) * threads);
+	pthread_t *handles = (pthread_t *) malloc(sizeof(pthread_t) * threads);
+	for (int t = 0; t < threads; t++)
+	{
+		workers[t] = *search;
+		workers[t].facilities = (facility_st *) malloc(sizeof(facility_st) * num_facilities);
+		memcpy(workers[t].facilities, search->facilities, sizeof(facility_st) * num_facilities);
+		workers[t].solution = (size_t *) malloc(sizeof(size_t) * num_customers);
+		workers[t].pruned_lower = CFLP_VAL_MAX;
+		workers[t].tails = search->tails != NULL ? (facility_tuple_st **) calloc(num_customers, sizeof(facility_tuple_st *)) : NULL;
+		if (search->options->table_mb > 0)
+		{
+			workers[t].table = createTable(search->options->table_mb * 1024 * 1024 / threads, &workers[t].table_mask);
+		}
+#ifdef CFLP_STATS
+		workers[t].stats = cflp_stats_create_child(search->stats);
+#endif
+		if (search->shared->deterministic)
+		{
+			workers[t].thread = t;
+		}
+		if (num_replicas > 0)
+		{
+			const replica_st *replica = &replicas[t % num_replicas];
+			workers[t].node = replica->node;
+			workers[t].begin = replica->begin;
+			workers[t].guide = search->guide != NULL ? replica->guide : NULL;
+		}
+	}
+	// the calling thread gets its cpus back after its part
+	cpu_set_t cpus;
+	int restore = workers[0].node >= 0 && pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+	int *started = (int *) calloc(threads, sizeof(int));
+	bnb_shared_st *shared = search->shared;
+	if (shared->deterministic)
+	{
+		shared->num_threads = threads;
+		shared->epoch_costs = (cflp_val *) malloc(sizeof(cflp_val) * threads);
+		shared->epoch_solutions = (size_t *) malloc(sizeof(size_t) * threads * (num_customers > 0 ? num_customers : 1));
+	}
+	for (int t = 1; t < threads; t++)
+	{
+		started[t] = pthread_create(&handles[t], NULL, shared->deterministic ? deterministicThread : searchThread, &workers[t]) == 0;
+		if (!started[t])
+		{
+			handles[t] = pthread_self(); // the other threads take over its subproblems
+		}
+	}
+	if (shared->deterministic)
+	{
+		if (workers[0].node >= 0)
+		{
+			cflp_memory_pin_thread(pthread_self(), workers[0].node);
+		}
+		runEpochs(search, workers, started);
+	}
+	else
+	{
+		searchThread(&workers[0]);
+	}
+	if (restore)
+	{
+		pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+	}
+	for (int t = 0; t < threads; t++)
+	{
+		if (t > 0 && !pthread_equal(handles[t], pthread_self()))
+		{
+			pthread_join(handles[t], NULL);
+		}
+		if (workers[t].pruned_lower < search->pruned_lower)
+		{
+			search->pruned_lower = workers[t].pruned_lower;
+		}
+#ifdef CFLP_STATS
+		cflp_stats_merge(search->stats, workers[t].stats);
+		cflp_stats_free(workers[t].stats);
+#endif
+		free(workers[t].facilities);
+		free(workers[t].solution);
+		free(workers[t].table);
+		freeTails(workers[t].tails, num_customers);
+	}
+	search->stop = search->shared->stop;
+	free(shared->epoch_costs);
+	free(shared->epoch_solutions);
+	shared->epoch_costs = NULL;
+	shared->epoch_solutions = NULL;
+	free(started);
+	free(handles);
+	free(workers);
+}
+
+int compareCustomerTuplesDsc(const void *a, const void *b)
+{
+	cflp_val x = ((const customer_tuple_st *) a)->key;
+	cflp_val y = ((const customer_tuple_st *) b)->key;
+	return x < y ? 1 : (x > y ? -1 : 0);
+}
+
+// assigns the customers in the given order to the facility with the smallest additional costs and
+// afterwards moves single customers as long as this gets cheaper, returns CFLP_VAL_INVALID if a customer does not fit
+cflp_val greedySolution(bnb_search_st *search, customer_tuple_st *order, size_t num_customers,
+						facility_tuple_st **assigned)
+{
+	facility_st *facilities = search->facilities;
+	cflp_val costs = 0;
+	size_t i;
+	for (i = 0; i < num_customers; i++)
+	{
+		customer_st *customer = order[i].customer;
+		facility_tuple_st *best = NULL;
+		cflp_val bestCost = CFLP_VAL_MAX;
+		for (facility_tuple_st *facilityTuple = customer->nearest;
+			 facilityTuple != NULL && facilityTuple->key < bestCost; facilityTuple = facilityTuple->next)
+		{
+			facility_st *facility = &facilities[facilityTuple->facility];
+			cflp_val newCost = recentCost(facility) + facilityTuple->key;
+			if (newCost < bestCost && canAddUser(facility, search->max_bandwidth, customer->key))
+			{
+				best = facilityTuple;
+				bestCost = newCost;
+			}
+		}
+		if (best == NULL)
+		{
+			break;
+		}
+		addUser(&facilities[best->facility], customer->key);
+		assigned[customer->num] = best;
+		costs += bestCost;
+	}
+
+	int improved = i == num_customers;
+	for (size_t pass = 0; improved && pass < 16; pass++)
+	{
+		improved = 0;
+		for (size_t j = 0; j < num_customers; j++)
+		{
+			customer_st *customer = order[j].customer;
+			facility_tuple_st *current = assigned[customer->num];
+			removeUser(&facilities[current->facility], customer->key);
+			cflp_val currentCost = recentCost(&facilities[current->facility]) + current->key;
+			for (facility_tuple_st *facilityTuple = customer->nearest;
+				 facilityTuple != NULL && facilityTuple->key < currentCost; facilityTuple = facilityTuple->next)
+			{
+				facility_st *facility = &facilities[facilityTuple->facility];
+				cflp_val newCost = recentCost(facility) + facilityTuple->key;
+				if (newCost < currentCost && canAddUser(facility, search->max_bandwidth, customer->key))
+				{
+					costs += newCost - currentCost;
+					current = facilityTuple;
+					currentCost = newCost;
+					improved = 1;
+				}
+			}
+			addUser(&facilities[current->facility], customer->key);
+			assigned[customer->num] = current;
+		}
+	}
+
+	// leave the facilities empty for the branching
+	for (size_t j = 0; j < i; j++)
+	{
+		customer_st *customer = order[j].customer;
+		removeUser(&facilities[assigned[customer->num]->facility], customer->key);
+	}
+	return i == num_customers ? costs : CFLP_VAL_INVALID;
+}
+
+// tries a few customer orders for the greedy heuristic and reports the cheapest solution,
+// stops as soon as a solution reaches the target
+void upperBoundHeuristic(bnb_search_st *search, customer_st *customers, size_t num_customers)
+{
+	customer_tuple_st *order = (customer_tuple_st *) malloc(sizeof(customer_tuple_st) * num_customers);
+	facility_tuple_st **assigned = (facility_tuple_st **) malloc(sizeof(facility_tuple_st *) * num_customers);
+	for (int strategy = 0; strategy < 2 && !search->stop; strategy++)
+	{
+		for (size_t i = 0; i < num_customers; i++)
+		{
+			customer_st *customer = &customers[i];
+			order[i].customer = customer;
+			if (strategy == 0) // largest bandwidth first
+			{
+				order[i].key = customer->key;
+			}
+			else // largest regret first
+			{
+				order[i].key = customer->nearest->next != NULL ? customer->nearest->next->key - customer->nearest->key : 0;
+			}
+		}
+		qsort(order, num_customers, sizeof(customer_tuple_st), compareCustomerTuplesDsc);
+		cflp_val costs = greedySolution(search, order, num_customers, assigned);
+		if (costs != CFLP_VAL_INVALID && costs <= search->upper_bound_inc)
+		{
+			for (size_t i = 0; i < num_customers; i++)
+			{
+				search->solution[i] = assigned[i]->facility;
+			}
+			improveUpperBound(search, costs);
+		}
+	}
+	free(assigned);
+	free(order);
+}
+
+// reports the given assignment as incumbent, customers with an invalid facility or without room are
+// reassigned to the cheapest facility with room (largest bandwidth first); assigned gets the facility
+// per customer, NULL for customers that could not be placed
+void warmStart(bnb_search_st *search, customer_st *customers, size_t num_customers, size_t num_facilities,
+			   const size_t *warm, facility_tuple_st **assigned)
+{
+	facility_st *facilities = search->facilities;
+	customer_tuple_st *order = (customer_tuple_st *) malloc(sizeof(customer_tuple_st) * num_customers);
+	size_t num_unassigned = 0;
+	for (size_t i = 0; i < num_customers; i++)
+	{
+		customer_st *customer = &customers[i];
+		assigned[customer->num] = NULL;
+		for (facility_tuple_st *facilityTuple = customer->nearest; facilityTuple != NULL; facilityTuple = facilityTuple->next)
+		{
+			if (facilityTuple->facility == warm[customer->num])
+			{
+				if (canAddUser(&facilities[facilityTuple->facility], search->max_bandwidth, customer->key))
+				{
+					addUser(&facilities[facilityTuple->facility], customer->key);
+					assigned[customer->num] = facilityTuple;
+				}
+				break;
+			}
+		}
+		if (assigned[customer->num] == NULL)
+		{
+			order[num_unassigned].key = customer->key;
+			order[num_unassigned].customer = customer;
+			num_unassigned++;
+		}
+	}
+
+	// repair
+	qsort(order, num_unassigned, sizeof(customer_tuple_st), compareCustomerTuplesDsc);
+	int complete = 1;
+	for (size_t i = 0; i < num_unassigned; i++)
+	{
+		customer_st *customer = order[i].customer;
+		cflp_val bestCost = CFLP_VAL_MAX;
+		for (facility_tuple_st *facilityTuple = customer->nearest;
+			 facilityTuple != NULL && facilityTuple->key < bestCost; facilityTuple = facilityTuple->next)
+		{
+			facility_st *facility = &facilities[facilityTuple->facility];
+			cflp_val newCost = recentCost(facility) + facilityTuple->key;
+			if (newCost < bestCost && canAddUser(facility, search->max_bandwidth, customer->key))
+			{
+				assigned[customer->num] = facilityTuple;
+				bestCost = newCost;
+			}
+		}
+		if (assigned[customer->num] == NULL)
+		{
+			complete = 0;
+			continue;
+		}
+		addUser(&facilities[assigned[customer->num]->facility], customer->key);
+	}
+
+	cflp_val costs = 0;
+	for (size_t k = 0; k < num_facilities; k++)
+	{
+		costs += facilities[k].user > 0 ? facilities[k].opening_costs : 0;
+	}
+	for (size_t i = 0; i < num_customers; i++)
+	{
+		customer_st *customer = &customers[i];
+		if (assigned[customer->num] != NULL)
+		{
+			costs += assigned[customer->num]->key;
+			search->solution[customer->num] = assigned[customer->num]->facility;
+			removeUser(&facilities[assigned[customer->num]->facility], customer->key);
+		}
+	}
+	if (complete && costs <= search->upper_bound_inc)
+	{
+		improveUpperBound(search, costs);
+	}
+	free(order);
+}
+
+struct bnb_prepared_s
+{
+	cflp_instance *instance;
+	facility_st *facilities; // empty facilities, each search works on a copy
+	customer_st *customers;
+	customer_st *begin;
+	facility_tuple_st *nearest; // nearest lists of all customers in one allocation
+	size_t nearest_len; // entries per customer, fewer than the facilities for partial lists
+	size_t capacity; // customers and nearest lists allocated for added customers
+	cflp_val root_lower;
+};
+
+void linkNearest(bnb_prepared *prepared, size_t i)
+{
+	size_t nearest_len = prepared->nearest_len;
+	facility_tuple_st *nearest = prepared->nearest + i * nearest_len;
+	for (size_t k = 1; k < nearest_len; k++)
+	{
+		nearest[k - 1].next = &nearest[k];
+	}
+	nearest[nearest_len - 1].next = NULL;
+	prepared->customers[i].nearest = nearest;
+	prepared->customers[i].last = nearest_len < prepared->instance->num_facilities ? &nearest[nearest_len - 1] : NULL;
+}
+
+void initCustomer(bnb_prepared *prepared, size_t i);
+
+// sorts the nearest list of a customer, a partial list keeps the cheapest facilities
+void prepareCustomer(bnb_prepared *prepared, size_t i)
+{
+	cflp_instance *instance = prepared->instance;
+	facility_tuple_st *nearest = prepared->nearest + i * prepared->nearest_len;
+	facility_tuple_st *all = nearest;
+	if (prepared->nearest_len < instance->num_facilities)
+	{
+		all = (facility_tuple_st *) malloc(sizeof(facility_tuple_st) * instance->num_facilities);
+	}
+	for (size_t k = 0; k < instance->num_facilities; k++)
+	{
+		all[k].key = CFLP_INSTANCE_DISTANCE(instance, k, i) * instance->distance_costs;
+		all[k].facility = k;
+		all[k].next = NULL;
+	}
+	merge_sort_asc(all, instance->num_facilities);
+	if (all != nearest)
+	{
+		memcpy(nearest, all, sizeof(facility_tuple_st) * prepared->nearest_len);
+		free(all);
+	}
+	initCustomer(prepared, i);
+}
+
+void initCustomer(bnb_prepared *prepared, size_t i)
+{
+	cflp_instance *instance = prepared->instance;
+	customer_st *customer = &prepared->customers[i];
+	customer->key = instance->cus_bandwidths[i];
+	customer->num = i;
+	customer->lower = 0;
+	customer->next = NULL;
+	customer->depth = i;
+	linkNearest(prepared, i);
+}
+
+// links the customer chain and calculates the bounds
+void linkCustomers(bnb_prepared *prepared)
+{
+	cflp_instance *instance = prepared->instance;
+	customer_st *customersBandwidth = prepared->customers;
+	// TODO: sort customersBandwidth here
+	customer_st *begin = &customersBandwidth[0];
+	customer_st *ptr = begin;
+	for (size_t i = 1; i < instance->num_customers; i++) {
+		ptr->next = &customersBandwidth[i];
+		ptr = ptr->next;
+	}
+	ptr->next = NULL;
+	// calculateLowerBound
+	cflp_val cost = 0;
+	customersBandwidth[instance->num_customers - 1].lower = cost;
+	for (size_t i = instance->num_customers - 1; i > 0; i--)
+	{
+		customer_st *customer = &customersBandwidth[i];
+		cflp_val minDistance = customer->nearest->key;
+		cost += minDistance;
+		customersBandwidth[i - 1].lower = cost;
+	}
+	// every solution pays at least the cheapest opening costs on top of the nearest distances
+	cflp_val min_opening_costs = CFLP_VAL_MAX;
+	for (size_t k = 0; k < instance->num_facilities; k++)
+	{
+		if (prepared->facilities[k].opening_costs < min_opening_costs)
+		{
+			min_opening_costs = prepared->facilities[k].opening_costs;
+		}
+	}
+	prepared->begin = begin;
+	prepared->root_lower = begin->lower + begin->nearest->key + min_opening_costs;
+}
+
+// Preprocessing cache: the header, then the facility order of the nearest list of each customer as
+// uint32_t, customer by customer. The keys follow from the distances.
+#define CACHE_MAGIC "CFLPPREP"
+#define CACHE_VERSION 1
+
+typedef struct
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	uint64_t instance_hash; // cflp_checkpoint_instance_hash()
+	uint64_t num_facilities;
+	uint64_t num_customers;
+	uint64_t nearest_len;
+	uint64_t order_hash; // of the facility order, detects damaged files
+} cache_header_st;
+
+uint64_t cacheOrderHash(const uint32_t *order, size_t num)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t k = 0; k < num; k++)
+	{
+		hash ^= order[k];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+// fills the nearest lists from the cache file, returns 0 if it is missing, stale or damaged
+int readCache(bnb_prepared *prepared, const char *path, unsigned long long instance_hash)
+{
+	cflp_instance *instance = prepared->instance;
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return 0;
+	}
+	struct stat st;
+	size_t num = prepared->nearest_len * instance->num_customers;
+	size_t size = sizeof(cache_header_st) + sizeof(uint32_t) * num;
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size != size)
+	{
+		close(fd);
+		return 0;
+	}
+	void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		return 0;
+	}
+	const cache_header_st *header = (const cache_header_st *) data;
+	const uint32_t *order = (const uint32_t *) (header + 1);
+	int valid = memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) == 0 && header->version == CACHE_VERSION
+		&& header->instance_hash == instance_hash && header->num_facilities == instance->num_facilities
+		&& header->num_customers == instance->num_customers && header->nearest_len == prepared->nearest_len
+		&& header->order_hash == cacheOrderHash(order, num);
+	for (size_t i = 0; i < instance->num_customers && valid; i++)
+	{
+		facility_tuple_st *nearest = prepared->nearest + i * prepared->nearest_len;
+		for (size_t k = 0; k < prepared->nearest_len && valid; k++)
+		{
+			size_t facility = order[i * prepared->nearest_len + k];
+			valid = facility < instance->num_facilities;
+			if (valid)
+			{
+				nearest[k].key = CFLP_INSTANCE_DISTANCE(instance, facility, i) * instance->distance_costs;
+				nearest[k].facility = facility;
+				valid = k == 0 || nearest[k - 1].key <= nearest[k].key;
+			}
+		}
+		if (valid)
+		{
+			initCustomer(prepared, i);
+		}
+	}
+	munmap(data, size);
+	return valid;
+}
+
+// replaces the cache file at once, so concurrent runs read either the old or the new one
+void writeCache(bnb_prepared *prepared, const char *path, unsigned long long instance_hash)
+{
+	cflp_instance *instance = prepared->instance;
+	size_t num = prepared->nearest_len * instance->num_customers;
+	uint32_t *order = (uint32_t *) malloc(sizeof(uint32_t) * (num > 0 ? num : 1));
+	for (size_t k = 0; k < num; k++)
+	{
+		order[k] = (uint32_t) prepared->nearest[k].facility;
+	}
+	cache_header_st header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+	header.version = CACHE_VERSION;
+	header.instance_hash = instance_hash;
+	header.num_facilities = instance->num_facilities;
+	header.num_customers = instance->num_customers;
+	header.nearest_len = prepared->nearest_len;
+	header.order_hash = cacheOrderHash(order, num);
+
+	size_t path_len = strlen(path);
+	char *temporary = (char *) malloc(path_len + 5);
+	memcpy(temporary, path, path_len);
+	memcpy(temporary + path_len, ".tmp", 5);
+	FILE *file = fopen(temporary, "wb");
+	int error = file == NULL;
+	if (!error)
+	{
+		error = fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(order, sizeof(uint32_t), num, file) != num;
+		error |= fclose(file) != 0;
+		error = error || rename(temporary, path) != 0;
+	}
+	if (error)
+	{
+		perror(path);
+		remove(temporary);
+	}
+	free(temporary);
+	free(order);
+}
+
+bnb_prepared *bnb_prepare(cflp_instance *instance, cflp_stats *stats)
+{
+	return bnb_prepare_nearest(instance, 0, stats);
+}
+
+bnb_prepared *bnb_prepare_nearest(cflp_instance *instance, size_t nearest_len, cflp_stats *stats)
+{
+	return bnb_prepare_cached(instance, nearest_len, NULL, stats);
+}
+
+bnb_prepared *bnb_prepare_cached(cflp_instance *instance, size_t nearest_len, const char *cache_path, cflp_stats *stats)
+{
+	if (stats != NULL) cflp_stats_phase_begin(stats, CFLP_PHASE_PREPROCESS);
+	bnb_prepared *prepared = (bnb_prepared *) malloc(sizeof(bnb_prepared));
+	if (prepared == NULL)
+	{
+		if (stats != NULL) cflp_stats_phase_end(stats, CFLP_PHASE_PREPROCESS);
+		return NULL;
+	}
+	prepared->instance = instance;
+	if (nearest_len == 0)
+	{
+		// complete lists as long as they fit the budget, otherwise as many entries as fit
+		size_t per_facility = sizeof(facility_tuple_st) * (instance->num_customers > 0 ? instance->num_customers : 1);
+		unsigned long long budget = CFLP_NEAREST_AUTO_BYTES;
+		if (cflp_instance_is_mapped(instance))
+		{
+			unsigned long long matrix = (unsigned long long) sizeof(cflp_distance) * instance->num_facilities * instance->num_customers;
+			budget = matrix / CFLP_NEAREST_MAPPED_DIVISOR < budget ? matrix / CFLP_NEAREST_MAPPED_DIVISOR : budget;
+		}
+		nearest_len = budget / per_facility;
+		nearest_len = nearest_len < CFLP_NEAREST_MIN ? CFLP_NEAREST_MIN : nearest_len;
+	}
+	prepared->nearest_len = nearest_len < instance->num_facilities ? nearest_len : instance->num_facilities;
+	prepared->capacity = instance->num_customers;
+	// calculateBestCustomers
+	prepared->customers = (customer_st *) cflp_memory_alloc(sizeof(customer_st) * instance->num_customers);
+	prepared->facilities = (facility_st *) malloc(sizeof(facility_st) * instance->num_facilities);
+	prepared->nearest = (facility_tuple_st *) cflp_memory_alloc(sizeof(facility_tuple_st) * prepared->nearest_len * instance->num_customers);
+	if (prepared->customers == NULL || prepared->facilities == NULL || prepared->nearest == NULL)
+	{
+		bnb_prepared_free(prepared);
+		if (stats != NULL) cflp_stats_phase_end(stats, CFLP_PHASE_PREPROCESS);
+		errno = ENOMEM;
+		return NULL;
+	}
+	for (size_t k = 0; k < instance->num_facilities; k++)
+	{
+		prepared->facilities[k].bandwidth = 0;
+		prepared->facilities[k].max_user = instance->fac_max_customers[k];
+		prepared->facilities[k].num = k;
+		prepared->facilities[k].opening_costs = instance->fac_opening_costs[k];
+		prepared->facilities[k].user = 0;
+	}
+	// the facility indices of the cache are 32 bits
+	int cache = cache_path != NULL && instance->num_facilities <= UINT32_MAX;
+	unsigned long long instance_hash = cache ? cflp_checkpoint_instance_hash(instance) : 0;
+	int cached = cache && readCache(prepared, cache_path, instance_hash);
+	// one pass over the rows; a mapped matrix is read ahead and its pages are dropped afterwards, so
+	// the search keeps only the nearest lists and the rows it scans beyond them in memory
+	if (!cached)
+	{
+		cflp_instance_distances_sequential(instance);
+	}
+	for (size_t i = 0; i < instance->num_customers && !cached; i++)
+	{
+		prepareCustomer(prepared, i);
+	}
+	cflp_instance_distances_release(instance);
+	linkCustomers(prepared);
+	if (cache && !cached)
+	{
+		writeCache(prepared, cache_path, instance_hash);
+	}
+	if (stats != NULL) cflp_stats_phase_end(stats, CFLP_PHASE_PREPROCESS);
+	return prepared;
+}
+
+cflp_instance *bnb_prepared_instance(bnb_prepared *prepared)
+{
+	return prepared->instance;
+}
+
+cflp_val bnb_prepared_root_lower_bound(bnb_prepared *prepared)
+{
+	return prepared->root_lower;
+}
+
+void bnb_prepared_set_bandwidth(bnb_prepared *prepared, size_t customer, cflp_val bandwidth)
+{
+	cflp_instance_set_bandwidth(prepared->instance, customer, bandwidth);
+	prepared->customers[customer].key = bandwidth;
+}
+
+void bnb_prepared_set_opening_costs(bnb_prepared *prepared, size_t facility, cflp_val opening_costs)
+{
+	cflp_instance_set_opening_costs(prepared->instance, facility, opening_costs);
+	prepared->facilities[facility].opening_costs = opening_costs;
+	linkCustomers(prepared); // the cheapest opening costs of the root bound
+}
+
+void bnb_prepared_set_max_customers(bnb_prepared *prepared, size_t facility, cflp_val max_customers)
+{
+	cflp_instance_set_max_customers(prepared->instance, facility, max_customers);
+	prepared->facilities[facility].max_user = max_customers;
+}
+
+size_t bnb_prepared_add_customer(bnb_prepared *prepared, cflp_val bandwidth, const cflp_val *distances)
+{
+	cflp_instance *instance = prepared->instance;
+	size_t customer = cflp_instance_add_customer(instance, bandwidth, distances);
+	if (customer == (size_t) -1)
+	{
+		return customer;
+	}
+	if (instance->num_customers > prepared->capacity)
+	{
+		prepared->capacity = prepared->capacity * 2;
+		prepared->customers = (customer_st *) cflp_memory_realloc(prepared->customers, sizeof(customer_st) * prepared->capacity);
+		prepared->nearest = (facility_tuple_st *) cflp_memory_realloc(prepared->nearest, sizeof(facility_tuple_st) * prepared->nearest_len * prepared->capacity);
+		for (size_t i = 0; i < customer; i++) // the lists moved, their order is kept
+		{
+			linkNearest(prepared, i);
+		}
+	}
+	prepareCustomer(prepared, customer);
+	linkCustomers(prepared);
+	return customer;
+}
+
+void bnb_prepared_free(bnb_prepared *prepared)
+{
+	cflp_memory_free(prepared->nearest);
+	cflp_memory_free(prepared->customers);
+	free(prepared->facilities);
+	free(prepared);
+}
+
+// the pointers of the replica lead into the replica instead of the prepared instance
+void createReplica(bnb_prepared *prepared, facility_tuple_st **guide, int node, replica_st *replica)
+{
+	size_t num_customers = prepared->instance->num_customers;
+	size_t num_nearest = prepared->nearest_len * num_customers;
+	replica->node = node;
+	replica->customers = (customer_st *) cflp_memory_alloc(sizeof(customer_st) * num_customers);
+	replica->nearest = (facility_tuple_st *) cflp_memory_alloc(sizeof(facility_tuple_st) * num_nearest);
+	if (node >= 0)
+	{
+		cflp_memory_bind(replica->customers, node);
+		cflp_memory_bind(replica->nearest, node);
+	}
+	memcpy(replica->nearest, prepared->nearest, sizeof(facility_tuple_st) * num_nearest);
+	for (size_t k = 0; k < num_nearest; k++)
+	{
+		if (prepared->nearest[k].next != NULL)
+		{
+			replica->nearest[k].next = replica->nearest + (prepared->nearest[k].next - prepared->nearest);
+		}
+	}
+	memcpy(replica->customers, prepared->customers, sizeof(customer_st) * num_customers);
+	for (size_t i = 0; i < num_customers; i++)
+	{
+		customer_st *customer = &prepared->customers[i];
+		replica->customers[i].nearest = replica->nearest + (customer->nearest - prepared->nearest);
+		replica->customers[i].last = customer->last != NULL ? replica->nearest + (customer->last - prepared->nearest) : NULL;
+		replica->customers[i].next = customer->next != NULL ? replica->customers + (customer->next - prepared->customers) : NULL;
+	}
+	replica->begin = replica->customers + (prepared->begin - prepared->customers);
+	replica->guide = NULL;
+	if (guide != NULL)
+	{
+		replica->guide = (facility_tuple_st **) malloc(sizeof(facility_tuple_st *) * num_customers);
+		for (size_t i = 0; i < num_customers; i++)
+		{
+			replica->guide[i] = guide[i] != NULL ? replica->nearest + (guide[i] - prepared->nearest) : NULL;
+		}
+	}
+}
+
+// places the read-only search data for a parallel search, returns the number of replicas (0 if the
+// threads share the prepared instance)
+int placeSearchData(bnb_prepared *prepared, facility_tuple_st **guide, cflp_placement placement, replica_st **replicas)
+{
+	*replicas = NULL;
+	int nodes[CFLP_MEMORY_MAX_NODES];
+	int num_nodes = cflp_memory_nodes(nodes, CFLP_MEMORY_MAX_NODES);
+	if (num_nodes <= 1 || placement == CFLP_PLACEMENT_LOCAL)
+	{
+		return 0;
+	}
+	if (placement == CFLP_PLACEMENT_INTERLEAVE)
+	{
+		cflp_instance *instance = prepared->instance;
+		cflp_memory_interleave(prepared->nearest);
+		cflp_memory_interleave(prepared->customers);
+		if (!cflp_instance_is_mapped(instance)) // the page cache places a mapped matrix
+		{
+			cflp_memory_interleave(instance->distances != NULL ? (void *) instance->distances : (void *) instance->distances16);
+		}
+		return 0;
+	}
+	// each copy is written from its node, so also the small ones of malloc() land there
+	cpu_set_t cpus;
+	int restore = pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+	*replicas = (replica_st *) malloc(sizeof(replica_st) * num_nodes);
+	for (int n = 0; n < num_nodes; n++)
+	{
+		cflp_memory_pin_thread(pthread_self(), nodes[n]);
+		createReplica(prepared, guide, nodes[n], &(*replicas)[n]);
+	}
+	if (restore)
+	{
+		pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+	}
+	return num_nodes;
+}
+
+void freeReplicas(replica_st *replicas, int num_replicas)
+{
+	for (int n = 0; n < num_replicas; n++)
+	{
+		cflp_memory_free(replicas[n].customers);
+		cflp_memory_free(replicas[n].nearest);
+		free(replicas[n].guide);
+	}
+	free(replicas);
+}
+
+// element i (from 1) of the Luby sequence 1, 1, 2, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 4, 8, ...
+unsigned long long lubyTerm(unsigned long long i)
+{
+	for (;;)
+	{
+		unsigned long long power = 1;
+		while (2 * power - 1 < i)
+		{
+			power *= 2;
+		}
+		if (2 * power - 1 == i)
+		{
+			return power;
+		}
+		i -= power - 1;
+	}
+}
+
+unsigned long long nextRandom(unsigned long long *state)
+{
+	// splitmix64
+	unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+// Shuffles the customer order and the facilities of equal costs in each nearest list of the copy;
+// the lists stay sorted, so the bounding and Theo's improvement hold. The lower bounds follow the order.
+void shuffleReplica(replica_st *replica, size_t num_customers, unsigned long long *state)
+{
+	customer_st **order = (customer_st **) malloc(sizeof(customer_st *) * num_customers);
+	for (size_t i = 0; i < num_customers; i++)
+	{
+		customer_st *customer = &replica->customers[i];
+		order[i] = customer;
+		size_t guided = replica->guide != NULL && replica->guide[i] != NULL ? replica->guide[i]->facility : (size_t) -1;
+		facility_tuple_st *run = customer->nearest;
+		while (run != NULL)
+		{
+			// the entries of one key are consecutive in the array
+			size_t length = 1;
+			facility_tuple_st *end = run->next;
+			for (; end != NULL && end->key == run->key; end = end->next)
+			{
+				length++;
+			}
+			for (size_t k = length; k > 1; k--)
+			{
+				size_t j = nextRandom(state) % k;
+				size_t facility = run[k - 1].facility;
+				run[k - 1].facility = run[j].facility;
+				run[j].facility = facility;
+			}
+			for (size_t k = 0; k < length && guided != (size_t) -1; k++)
+			{
+				if (run[k].facility == guided)
+				{
+					replica->guide[i] = &run[k];
+				}
+			}
+			run = end;
+		}
+	}
+	for (size_t i = num_customers; i > 1; i--)
+	{
+		size_t j = nextRandom(state) % i;
+		customer_st *customer = order[i - 1];
+		order[i - 1] = order[j];
+		order[j] = customer;
+	}
+	cflp_val lower = 0;
+	for (size_t i = num_customers; i-- > 0;)
+	{
+		order[i]->depth = i;
+		order[i]->next = i + 1 < num_customers ? order[i + 1] : NULL;
+		order[i]->lower = lower;
+		lower += order[i]->nearest->key;
+	}
+	replica->begin = order[0];
+	free(order);
+}
+
+// Restarts the search with a node limit of restart_nodes times the Luby sequence. The first run uses
+// the prepared order, the later ones a copy with a random customer order and random ties in the
+// nearest lists. The incumbent carries over; a run within its limit is complete.
+void restartSearch(bnb_search_st *search, bnb_prepared *prepared, unsigned long long restart_nodes,
+				   unsigned long long seed)
+{
+	customer_st *begin = search->begin;
+	facility_tuple_st **guide = search->guide;
+	replica_st replica;
+	replica.customers = NULL;
+	unsigned long long state = seed;
+	for (unsigned long long run = 1;; run++)
+	{
+		unsigned long long term = lubyTerm(run);
+		search->restart_limit = restart_nodes < ULLONG_MAX / term ? restart_nodes * term : ULLONG_MAX;
+		search->restart_nodes = 0;
+		search->restarting = 0;
+		search->limit_countdown = 4096;
+		search->pruned_lower = CFLP_VAL_MAX;
+		if (run > 1)
+		{
+			if (replica.customers == NULL)
+			{
+				createReplica(prepared, guide, -1, &replica);
+			}
+			shuffleReplica(&replica, search->num_customers, &state);
+			search->begin = replica.begin;
+			search->guide = replica.guide;
+			CFLP_STATS_COUNT(search->stats, restarts);
+		}
+		searchSubtree(search, search->begin, 0);
+		search->stop = __atomic_load_n(&search->shared->stop, __ATOMIC_RELAXED);
+		if (!search->restarting || search->stop)
+		{
+			break;
+		}
+	}
+	search->restart_limit = 0;
+	search->begin = begin;
+	search->guide = guide;
+	if (replica.customers != NULL)
+	{
+		cflp_memory_free(replica.customers);
+		cflp_memory_free(replica.nearest);
+		free(replica.guide);
+	}
+}
+
+bnb_status bnb_run(void *context, cflp_instance *instance, const bnb_options *options)
+{
+	bnb_prepared *prepared = bnb_prepare_cached(instance, options != NULL ? options->nearest_len : 0,
+												options != NULL ? options->cache_path : NULL, options != NULL ? options->stats : NULL);
+	if (prepared == NULL)
+	{
+		return BNB_STOPPED;
+	}
+	bnb_status status = bnb_run_prepared(context, prepared, options);
+	bnb_prepared_free(prepared);
+	return status;
+}
+
+// a checkpoint of another instance (or a corrupted one) could lead the search outside the instance
+int checkpointFits(const cflp_checkpoint *checkpoint, cflp_instance *instance)
+{
+	if (checkpoint->path_len > instance->num_customers)
+	{
+		return 0;
+	}
+	for (size_t i = 0; i < checkpoint->path_len; i++)
+	{
+		if (checkpoint->path[i] >= instance->num_facilities)
+		{
+			return 0;
+		}
+	}
+	return checkpoint->incumbent == CFLP_VAL_INVALID || (checkpoint->num_customers == instance->num_customers &&
+		cflp_instance_check_solution(instance, checkpoint->solution, checkpoint->num_customers) == CFLP_SOLUTION_VALID);
+}
+
+// The search of bnb_run_prepared() without the pool. With exclude it only accepts solutions distinct
+// from the members (the pass for the next member, sequential depth-first without warm start); best
+// (may be NULL) receives the incumbent and best_cost its costs, CFLP_VAL_MAX without one.
+bnb_status runSearch(void *context, bnb_prepared *prepared, const bnb_options *options, const cflp_pool *exclude,
+					 size_t *best, cflp_val *best_cost)
+{
+	bnb_options defaults;
+	if (options == NULL)
+	{
+		bnb_options_init(&defaults);
+		options = &defaults;
+	}
+	cflp_instance *instance = prepared->instance;
+	cflp_stats *stats = options->stats;
+#ifdef CFLP_STATS
+	if (stats == NULL)
+	{
+		stats = cflp_stats_create();
+	}
+	cflp_stats_set_depth(stats, instance->num_customers);
+#endif
+
+	cflp_val root_lower = prepared->root_lower;
+	if (options->lower_bound != CFLP_VAL_INVALID && options->lower_bound > root_lower)
+	{
+		root_lower = options->lower_bound;
+	}
+	reportLowerBound(context, options, root_lower);
+
+	facility_st *facilities = (facility_st *) malloc(sizeof(facility_st) * instance->num_facilities);
+	memcpy(facilities, prepared->facilities, sizeof(facility_st) * instance->num_facilities);
+	size_t* solution = (size_t*)malloc(sizeof(size_t)* instance->num_customers);
+
+	bnb_shared_st shared;
+	pthread_mutex_init(&shared.mutex, NULL);
+	shared.incumbent = CFLP_VAL_MAX;
+	shared.upper_bound_inc = options->target != CFLP_VAL_INVALID ? options->target : CFLP_VAL_MAX;
+	shared.stop = BNB_COMPLETE;
+	shared.proven = 0;
+	shared.deterministic = options->deterministic;
+	pthread_cond_init(&shared.epoch_cond, NULL);
+	shared.epoch = 0;
+	shared.epoch_done = 0;
+	shared.epoch_exit = 0;
+	shared.epoch_costs = NULL;
+	shared.epoch_solutions = NULL;
+	shared.num_threads = 1;
+	shared.prefixes = NULL;
+	shared.prefix_costs = NULL;
+	shared.prefix_depth = 0;
+	shared.prefix_count = 0;
+	shared.prefix_capacity = 0;
+	shared.prefix_next = 0;
+
+	bnb_search_st search;
+	search.context = context;
+	search.facilities = facilities;
+	search.solution = solution;
+	search.solution_len = instance->num_customers;
+	search.max_bandwidth = instance->max_bandwith;
+	search.upper_bound_inc = shared.upper_bound_inc;
+	search.pruned_lower = CFLP_VAL_MAX;
+	search.tolerance_abs = options->tolerance_abs;
+	search.tolerance_rel = options->tolerance_rel;
+	search.target = options->target;
+	search.stop = BNB_COMPLETE;
+	search.options = options;
+	search.deadline_us = options->time_limit_ms > 0 ? cflp_stats_now_us() + options->time_limit_ms * 1000 : 0;
+	search.limit_countdown = 1;
+	search.stats = stats;
+	search.shared = &shared;
+	search.begin = prepared->begin;
+	search.guide = NULL;
+	search.checkpoint = NULL;
+	search.instance_hash = 0;
+	search.checkpoint_us = 0;
+	search.begin_us = 0;
+	search.elapsed_ms = 0;
+	search.best = NULL;
+	search.stop_depth = 0;
+	search.resume = NULL;
+	search.resume_len = 0;
+	search.resuming = 0;
+	search.table = NULL;
+	search.table_mask = 0;
+	search.hash = 0;
+	search.table_depth = instance->num_customers / 2;
+	search.num_customers = instance->num_customers;
+	search.num_facilities = instance->num_facilities;
+	search.kernel_width = 0;
+	search.instance = instance;
+	search.tails = prepared->nearest_len < instance->num_facilities
+		? (facility_tuple_st **) calloc(instance->num_customers, sizeof(facility_tuple_st *)) : NULL;
+	search.node = -1;
+	search.discrepancy_cut = 0;
+	search.restart_limit = 0;
+	search.restart_nodes = 0;
+	search.restarting = 0;
+	search.thread = -1;
+	search.exclude = exclude;
+	search.mismatches = exclude != NULL ? (size_t *) calloc(cflp_pool_size(exclude) + 1, sizeof(size_t)) : NULL;
+
+	// checkpoints describe the position in the tree of a sequential search
+	const cflp_checkpoint *resume = options->resume;
+	if (resume != NULL && !checkpointFits(resume, instance))
+	{
+		resume = NULL;
+	}
+	int threads = options->checkpoint_path != NULL || resume != NULL ? 1 : options->threads;
+	// checkpoints and resumes describe a position of the depth-first search
+	bnb_strategy strategy = options->checkpoint_path != NULL || resume != NULL ? BNB_STRATEGY_DEPTH_FIRST : options->strategy;
+	int restarts = options->restart_nodes > 0 && strategy != BNB_STRATEGY_DISCREPANCY
+		&& options->checkpoint_path == NULL && resume == NULL;
+	if (restarts)
+	{
+		threads = 1;
+	}
+	if (options->checkpoint_path != NULL)
+	{
+		search.instance_hash = cflp_checkpoint_instance_hash(instance);
+	}
+	if (best != NULL)
+	{
+		search.best = best;
+	}
+	else if (options->checkpoint_path != NULL)
+	{
+		search.best = (size_t *) calloc(instance->num_customers > 0 ? instance->num_customers : 1, sizeof(size_t));
+	}
+
+	CFLP_STATS_PHASE_BEGIN(stats, CFLP_PHASE_HEURISTIC);
+	int searched = 1;
+	if (resume != NULL)
+	{
+		search.elapsed_ms = resume->elapsed_ms;
+		search.pruned_lower = resume->pruned_lower;
+#ifdef CFLP_STATS
+		// the nodes on the path are entered again
+		unsigned long long entered = resume->done ? 0 : (resume->path_len < instance->num_customers ? resume->path_len + 1 : resume->path_len);
+		stats->nodes += resume->nodes > entered ? resume->nodes - entered : 0;
+		stats->pruned_bound += resume->pruned_bound;
+		stats->pruned_capacity += resume->pruned_capacity;
+		stats->pruned_theo += resume->pruned_theo;
+#endif
+		if (resume->incumbent != CFLP_VAL_INVALID)
+		{
+			memcpy(solution, resume->solution, sizeof(size_t) * instance->num_customers);
+			improveUpperBound(&search, resume->incumbent);
+		}
+		searched = !resume->done;
+		search.resume = resume->path;
+		search.resume_len = resume->path_len;
+		search.resuming = resume->path_len > 0;
+	}
+	facility_tuple_st **warm = NULL;
+	if (options->warm_start != NULL && searched)
+	{
+		warm = (facility_tuple_st **) malloc(sizeof(facility_tuple_st *) * instance->num_customers);
+		warmStart(&search, prepared->customers, instance->num_customers, instance->num_facilities, options->warm_start, warm);
+		if (options->warm_start_branching && options->checkpoint_path == NULL && resume == NULL)
+		{
+			search.guide = warm;
+		}
+	}
+	if (searched)
+	{
+		upperBoundHeuristic(&search, prepared->customers, instance->num_customers);
+	}
+	CFLP_STATS_PHASE_END(stats, CFLP_PHASE_HEURISTIC);
+	CFLP_STATS_PHASE_BEGIN(stats, CFLP_PHASE_SEARCH);
+	search.begin_us = cflp_stats_now_us();
+	if (!search.stop && searched && strategy == BNB_STRATEGY_BEAM)
+	{
+		beamSearch(&search, options->beam_width);
+	}
+	if (!search.stop && searched && strategy == BNB_STRATEGY_DISCREPANCY)
+	{
+		discrepancySearch(&search);
+	}
+	else if (!search.stop && searched)
+	{
+		if (options->checkpoint_path != NULL)
+		{
+			// without writer thread only the final checkpoint is written
+			search.checkpoint = cflp_checkpoint_writer_create(options->checkpoint_path, instance->num_customers);
+			search.checkpoint_us = search.begin_us + options->checkpoint_interval_ms * 1000;
+		}
+		if (options->table_mb > 0 && threads == 1 && !restarts) // the depths of the states change with the order
+		{
+			search.table = createTable(options->table_mb * 1024 * 1024, &search.table_mask);
+		}
+		if (search.guide == NULL && options->table_mb == 0 && search.resume_len == 0 && exclude == NULL)
+		{
+			// the smallest kernel that fits the instance
+			for (int width = 16; width <= 64 && search.kernel_width == 0; width *= 2)
+			{
+				if (instance->num_facilities <= (size_t) width)
+				{
+					search.kernel_width = width;
+				}
+			}
+		}
+		if (threads > 1)
+		{
+			replica_st *replicas;
+			int num_replicas = placeSearchData(prepared, search.guide, options->placement, &replicas);
+			parallelSearch(&search, instance->num_facilities, instance->num_customers, threads, replicas, num_replicas);
+			freeReplicas(replicas, num_replicas);
+		}
+		else if (restarts)
+		{
+			restartSearch(&search, prepared, options->restart_nodes, options->restart_seed);
+		}
+		else
+		{
+			searchSubtree(&search, prepared->begin, 0);
+		}
+		if (search.checkpoint != NULL)
+		{
+			cflp_checkpoint_writer_free(search.checkpoint);
+			search.checkpoint = NULL;
+		}
+		free(search.table);
+		search.table = NULL;
+	}
+	CFLP_STATS_PHASE_END(stats, CFLP_PHASE_SEARCH);
+
+	if (shared.proven)
+	{
+		search.stop = BNB_COMPLETE;
+		search.pruned_lower = options->lower_bound; // the optimum is between it and the incumbent
+	}
+	if (!search.stop)
+	{
+		// the search is complete: the optimum is either the incumbent or hidden in a pruned subtree
+		reportLowerBound(context, options, shared.incumbent < search.pruned_lower ? shared.incumbent : search.pruned_lower);
+	}
+	if (options->checkpoint_path != NULL)
+	{
+		// a time limit or cancel continues at the stopped node, otherwise a resume starts at the root
+		cflp_checkpoint *checkpoint = cflp_checkpoint_create(instance->num_customers);
+		if (checkpoint != NULL)
+		{
+			fillCheckpoint(&search, checkpoint, search.stop == BNB_STOPPED ? search.stop_depth : 0);
+			checkpoint->done = search.stop == BNB_COMPLETE;
+		}
+		if (checkpoint == NULL || cflp_checkpoint_write(checkpoint, options->checkpoint_path) != 0)
+		{
+			perror(options->checkpoint_path);
+		}
+		if (checkpoint != NULL)
+		{
+			cflp_checkpoint_free(checkpoint);
+		}
+	}
 	
-	for (size_t i = 0; i < instance->num_customers; i++)
+	if (best_cost != NULL)
 	{
-		free(customersBandwidth[i].nearest);
-		customersBandwidth[i].nearest = NULL;
+		*best_cost = shared.incumbent;
 	}
-	free(customersBandwidth);
+	free(solution);
+	if (search.best != best)
+	{
+		free(search.best);
+	}
+	free(search.mismatches);
+	freeTails(search.tails, instance->num_customers);
+	solution = NULL;
+	free(warm);
+	free(shared.prefixes);
+	free(shared.prefix_costs);
+	pthread_mutex_destroy(&shared.mutex);
+	pthread_cond_destroy(&shared.epoch_cond);
 	free(facilities);
+#ifdef CFLP_STATS
+	cflp_stats_publish(stats, 0);
+	if (stats != options->stats)
+	{
+		cflp_stats_free(stats);
+	}
+#endif
+	return search.stop;
+}
+
+// Each further member is the cheapest solution distinct from the members before it, found by a pass
+// of its own with the time left, so the pool does not weaken the bound of the main search. The passes
+// stop when the pool is full, no distinct solution is left or one is cut short.
+void fillPool(bnb_prepared *prepared, const bnb_options *options, cflp_pool *pool, size_t *best, cflp_val cost,
+			  bnb_status status, long long deadline_us)
+{
+	bnb_options pass = *options;
+	pass.threads = 1;
+	pass.strategy = BNB_STRATEGY_DEPTH_FIRST;
+	pass.restart_nodes = 0;
+	pass.deterministic = 0;
+	pass.table_mb = 0; // it would prune prefixes that lead to distinct solutions
+	pass.checkpoint_path = NULL;
+	pass.resume = NULL;
+	pass.warm_start = NULL;
+	pass.target = CFLP_VAL_INVALID;
+	pass.lower_bound = CFLP_VAL_INVALID;
+	pass.on_solution = NULL;
+	pass.on_lower_bound = NULL;
+	pass.stats = NULL;
+	pass.pool = NULL;
+	while (status != BNB_STOPPED && cost != CFLP_VAL_MAX && cflp_pool_add(pool, cost, best) && cflp_pool_bound(pool) == CFLP_VAL_MAX)
+	{
+		if (deadline_us > 0)
+		{
+			pass.time_limit_ms = (deadline_us - cflp_stats_now_us()) / 1000;
+			if (pass.time_limit_ms <= 0)
+			{
+				break;
+			}
+		}
+		status = runSearch(NULL, prepared, &pass, pool, best, &cost);
+	}
+}
+
+bnb_status bnb_run_prepared(void *context, bnb_prepared *prepared, const bnb_options *options)
+{
+	// a pool of another instance is ignored like a checkpoint of another instance
+	cflp_pool *pool = options != NULL && options->pool != NULL
+		&& cflp_pool_num_customers(options->pool) == prepared->instance->num_customers ? options->pool : NULL;
+	if (pool == NULL)
+	{
+		return runSearch(context, prepared, options, NULL, NULL, NULL);
+	}
+	cflp_pool_clear(pool);
+	long long deadline_us = options->time_limit_ms > 0 ? cflp_stats_now_us() + options->time_limit_ms * 1000 : 0;
+	size_t num_customers = prepared->instance->num_customers;
+	size_t *best = (size_t *) malloc(sizeof(size_t) * (num_customers > 0 ? num_customers : 1));
+	cflp_val cost;
+	bnb_status status = runSearch(context, prepared, options, NULL, best, &cost);
+	fillPool(prepared, options, pool, best, cost, status, deadline_us);
+	free(best);
+	return status;
 }
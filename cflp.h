@@ -1,5 +1,153 @@
+#include <stddef.h>
 #include "cflp_instance.h"
+#include "cflp_stats.h"
+#include "cflp_checkpoint.h"
+#include "cflp_memory.h"
+#include "cflp_pool.h"
 
-void bnb_set_solution(void* context, cflp_val new_upper_bound, size_t* new_solution, size_t new_solution_length);
+#ifndef __CFLP_HEADER
+#define __CFLP_HEADER
 
-void bnb_run(void *context, cflp_instance *instance);
+// automatic nearest list length: complete lists up to this memory, otherwise as many entries as fit
+// (at least CFLP_NEAREST_MIN per customer)
+#define CFLP_NEAREST_AUTO_BYTES (512ULL * 1024 * 1024)
+#define CFLP_NEAREST_MIN 32
+// mapped instances (cflp_instance_create_mapped()) get shorter lists: at most the size of their matrix
+// divided by this, so the search needs far less memory than the matrix
+#define CFLP_NEAREST_MAPPED_DIVISOR 4
+
+// order in which the search tree is explored, all use the same bounds
+typedef enum
+{
+	BNB_STRATEGY_DEPTH_FIRST,
+	// passes with at most 0, 1, 2, ... deviations from the first facility with room per customer, the
+	// last pass is complete; on one thread
+	BNB_STRATEGY_DISCREPANCY,
+	// a beam search of beam_width for an early incumbent, then the depth-first search
+	BNB_STRATEGY_BEAM
+} bnb_strategy;
+
+typedef enum
+{
+	BNB_COMPLETE, // the search space is exhausted, the reported lower bound is proven
+	BNB_TARGET_REACHED, // decision mode found a solution with costs <= target
+	BNB_STOPPED // time limit or cancel
+} bnb_status;
+
+// called with each improved solution, the solution array is only valid during the call
+typedef void (*bnb_solution_callback)(void* context, cflp_val new_upper_bound, size_t* new_solution, size_t new_solution_length);
+
+typedef void (*bnb_lower_bound_callback)(void* context, cflp_val new_lower_bound);
+
+typedef struct
+{
+	bnb_solution_callback on_solution;
+	bnb_lower_bound_callback on_lower_bound;
+	// the search stops soon after another thread sets *cancel to non-zero (atomically), may be NULL
+	int *cancel;
+	// a solution is accepted as optimal if no other solution is cheaper by more than
+	// max(tolerance_abs, tolerance_rel * costs), e.g. tolerance_rel = 0.005 for 0.5%
+	cflp_val tolerance_abs;
+	double tolerance_rel;
+	// decision mode: only solutions with costs <= target are searched and the search returns with
+	// the first one, CFLP_VAL_INVALID to search for the optimum
+	cflp_val target;
+	// the search stops after this many milliseconds, 0 for no limit
+	long long time_limit_ms;
+	// initial solution, the facility index per customer (e.g. the previous plan), customers that violate
+	// the limits are reassigned greedily, may be NULL
+	const size_t *warm_start;
+	// branch on the facility of warm_start first for each customer
+	int warm_start_branching;
+	// known lower bound of the optimum (e.g. of a previous solve before deltas that can not make the
+	// instance cheaper), the search is complete as soon as a solution reaches it; CFLP_VAL_INVALID if unknown
+	cflp_val lower_bound;
+	// number of search threads, the search tree is split into subproblems if > 1
+	int threads;
+	// The threads search the subproblems in epochs: one subproblem per thread with the bound of the epoch
+	// start, then the cheapest solution of the epoch (equal costs by the assignment) becomes the incumbent.
+	// For a thread count the incumbents, node counts and the result are the same in every run that is
+	// not cut short by the time limit or cancel; the threads wait for the slowest one of each epoch
+	// (see the epoch statistics).
+	int deterministic;
+	// the search state is written to this file every checkpoint_interval_ms and when the search ends,
+	// may be NULL; checkpoints force a sequential search without warm start branching
+	const char *checkpoint_path;
+	long long checkpoint_interval_ms;
+	// continues the search of a checkpoint of the same instance (the caller compares instance_hash),
+	// may be NULL; the time limit applies to the continued run only
+	const cflp_checkpoint *resume;
+	// memory of the transposition table in MiB (split among the threads), it prunes nodes whose facility
+	// states were reached by a cheaper prefix before; 0 to disable
+	size_t table_mb;
+	// entries of the nearest list of each customer for bnb_run() (see bnb_prepare_nearest()), 0 for automatic
+	size_t nearest_len;
+	// NUMA placement of the nearest lists and distances for a search with threads > 1, see cflp_placement
+	cflp_placement placement;
+	// search order, checkpoints and resumes force BNB_STRATEGY_DEPTH_FIRST
+	bnb_strategy strategy;
+	// partial solutions per level of BNB_STRATEGY_BEAM, each one with a copy of the facilities
+	size_t beam_width;
+	// restarts of the depth-first search after restart_nodes times the Luby sequence (1, 1, 2, 1, 1, 2,
+	// 4, ...) nodes with a random customer order and random ties in the nearest lists, so one bad early
+	// decision does not take the whole time limit (counted in steps of 4096 nodes); 0 for no restarts. The
+	// search runs on one thread, the incumbent carries over and restart_seed makes the runs reproducible.
+	unsigned long long restart_nodes;
+	unsigned long long restart_seed;
+	// collects the cheapest distinct solutions (see cflp_pool.h): the incumbent of the search, then per
+	// further member a sequential depth-first pass for the cheapest solution distinct from the members
+	// so far, with the time left. The search itself is unchanged, the passes only follow a search that
+	// was not stopped. Cleared at the start, ignored if it has another number of customers; may be NULL.
+	cflp_pool *pool;
+	// cache file of the preprocessing of bnb_run() (see bnb_prepare_cached()), may be NULL
+	const char *cache_path;
+	// search statistics are collected here if not NULL (see CFLP_STATS)
+	cflp_stats *stats;
+} bnb_options;
+
+void bnb_options_init(bnb_options *options);
+
+// bnb_run() has no global state, any number of searches may run concurrently (also on the same instance)
+bnb_status bnb_run(void *context, cflp_instance *instance, const bnb_options *options);
+
+// instance with its sorted nearest lists and bounds, only read by the searches
+typedef struct bnb_prepared_s bnb_prepared;
+
+// the preprocessing of bnb_run(), the instance has to outlive the result; stats may be NULL. Returns
+// NULL with errno ENOMEM if the lists can not be allocated (bnb_run() then returns BNB_STOPPED).
+bnb_prepared *bnb_prepare(cflp_instance *instance, cflp_stats *stats);
+
+// Keeps only the nearest_len cheapest facilities of each customer (0 for automatic), so the memory
+// grows with customers * nearest_len. The search scans the other facilities of a customer only at
+// the nodes where the bound admits them, the results are the same as with complete lists.
+// The heuristics only see the partial lists.
+bnb_prepared *bnb_prepare_nearest(cflp_instance *instance, size_t nearest_len, cflp_stats *stats);
+
+// Reads the nearest lists from the cache file if it belongs to the instance and nearest_len, otherwise
+// prepares the instance and (re)writes the file. The file is checked against a hash of all numbers of
+// the instance, so a stale or damaged cache is rebuilt. cache_path may be NULL.
+bnb_prepared *bnb_prepare_cached(cflp_instance *instance, size_t nearest_len, const char *cache_path, cflp_stats *stats);
+
+// like bnb_run() without the preprocessing, any number of searches may share the prepared instance
+bnb_status bnb_run_prepared(void *context, bnb_prepared *prepared, const bnb_options *options);
+
+cflp_instance *bnb_prepared_instance(bnb_prepared *prepared);
+
+cflp_val bnb_prepared_root_lower_bound(bnb_prepared *prepared);
+
+// deltas of the instance that only update the affected nearest lists and bounds,
+// only while no search runs on the prepared instance
+
+void bnb_prepared_set_bandwidth(bnb_prepared *prepared, size_t customer, cflp_val bandwidth);
+
+void bnb_prepared_set_opening_costs(bnb_prepared *prepared, size_t facility, cflp_val opening_costs);
+
+void bnb_prepared_set_max_customers(bnb_prepared *prepared, size_t facility, cflp_val max_customers);
+
+// appends a customer with its distance to each facility, returns its index or (size_t) -1 (see
+// cflp_instance_add_customer())
+size_t bnb_prepared_add_customer(bnb_prepared *prepared, cflp_val bandwidth, const cflp_val *distances);
+
+void bnb_prepared_free(bnb_prepared *prepared);
+
+#endif
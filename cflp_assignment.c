@@ -0,0 +1,418 @@
+#include "cflp_assignment.h"
+#include <errno.h>
+#include <stdlib.h>
+
+#define CFLP_ASSIGNMENT_NONE ((size_t) -1)
+
+typedef struct
+{
+	size_t customer;
+	size_t facility; // before the move
+} cflp_assignment_step;
+
+struct cflp_assignment_s
+{
+	cflp_instance *instance;
+	size_t *facilities; // per customer
+	// the customers of each facility as doubly linked lists, CFLP_ASSIGNMENT_NONE at the ends
+	size_t *first;
+	size_t *next;
+	size_t *prev;
+	cflp_val *bandwidths; // per facility
+	cflp_val *counts; // customers per facility
+	size_t *open; // facilities with customers in no particular order
+	size_t *open_pos; // index of the facility in open, CFLP_ASSIGNMENT_NONE if closed
+	size_t num_open;
+	cflp_val objective;
+	size_t violations;
+	cflp_assignment_step *log; // applied moves for cflp_assignment_undo()
+	size_t log_len;
+	size_t log_capacity;
+	// redistribution of a closed facility: the customers in list order and their new facilities
+	size_t *close_customers;
+	size_t *close_targets;
+	cflp_val *extra_bandwidths; // per facility, load taken over by the redistribution
+	cflp_val *extra_counts;
+	size_t *extra_facilities; // facilities with extra load
+};
+
+cflp_val cflp_assignment_costs(cflp_instance *instance, size_t facility, size_t customer)
+{
+	return CFLP_INSTANCE_DISTANCE(instance, facility, customer) * instance->distance_costs;
+}
+
+int cflp_assignment_violated(cflp_instance *instance, size_t facility, cflp_val bandwidth, cflp_val count)
+{
+	return bandwidth > instance->max_bandwith || count > instance->fac_max_customers[facility];
+}
+
+// the facility with its current load is beyond a limit
+int cflp_assignment_facility_violated(cflp_assignment *assignment, size_t facility)
+{
+	return cflp_assignment_violated(assignment->instance, facility, assignment->bandwidths[facility], assignment->counts[facility]);
+}
+
+void cflp_assignment_link(cflp_assignment *assignment, size_t customer, size_t facility)
+{
+	cflp_instance *instance = assignment->instance;
+	if (assignment->counts[facility] == 0)
+	{
+		assignment->objective += instance->fac_opening_costs[facility];
+		assignment->open_pos[facility] = assignment->num_open;
+		assignment->open[assignment->num_open++] = facility;
+	}
+	assignment->prev[customer] = CFLP_ASSIGNMENT_NONE;
+	assignment->next[customer] = assignment->first[facility];
+	if (assignment->first[facility] != CFLP_ASSIGNMENT_NONE)
+	{
+		assignment->prev[assignment->first[facility]] = customer;
+	}
+	assignment->first[facility] = customer;
+	assignment->bandwidths[facility] += instance->cus_bandwidths[customer];
+	assignment->counts[facility]++;
+	assignment->objective += cflp_assignment_costs(instance, facility, customer);
+	assignment->facilities[customer] = facility;
+}
+
+void cflp_assignment_unlink(cflp_assignment *assignment, size_t customer)
+{
+	cflp_instance *instance = assignment->instance;
+	size_t facility = assignment->facilities[customer];
+	if (assignment->prev[customer] != CFLP_ASSIGNMENT_NONE)
+	{
+		assignment->next[assignment->prev[customer]] = assignment->next[customer];
+	}
+	else
+	{
+		assignment->first[facility] = assignment->next[customer];
+	}
+	if (assignment->next[customer] != CFLP_ASSIGNMENT_NONE)
+	{
+		assignment->prev[assignment->next[customer]] = assignment->prev[customer];
+	}
+	assignment->bandwidths[facility] -= instance->cus_bandwidths[customer];
+	assignment->counts[facility]--;
+	assignment->objective -= cflp_assignment_costs(instance, facility, customer);
+	if (assignment->counts[facility] == 0)
+	{
+		assignment->objective -= instance->fac_opening_costs[facility];
+		size_t last = assignment->open[--assignment->num_open];
+		assignment->open[assignment->open_pos[facility]] = last;
+		assignment->open_pos[last] = assignment->open_pos[facility];
+		assignment->open_pos[facility] = CFLP_ASSIGNMENT_NONE;
+	}
+}
+
+// moves without undo log
+void cflp_assignment_apply(cflp_assignment *assignment, size_t customer, size_t facility)
+{
+	size_t previous = assignment->facilities[customer];
+	if (previous == facility)
+	{
+		return;
+	}
+	assignment->violations -= cflp_assignment_facility_violated(assignment, previous) + cflp_assignment_facility_violated(assignment, facility);
+	cflp_assignment_unlink(assignment, customer);
+	cflp_assignment_link(assignment, customer, facility);
+	assignment->violations += cflp_assignment_facility_violated(assignment, previous) + cflp_assignment_facility_violated(assignment, facility);
+}
+
+cflp_assignment *cflp_assignment_create(cflp_instance *instance, const size_t *solution, size_t solution_len)
+{
+	size_t num_customers = instance->num_customers;
+	size_t num_facilities = instance->num_facilities;
+	if (solution_len != num_customers)
+	{
+		errno = EINVAL;
+		return NULL;
+	}
+	for (size_t i = 0; i < num_customers; i++)
+	{
+		if (solution[i] >= num_facilities)
+		{
+			errno = EINVAL;
+			return NULL;
+		}
+	}
+	size_t customers = num_customers > 0 ? num_customers : 1;
+	size_t facilities = num_facilities > 0 ? num_facilities : 1;
+	cflp_assignment *assignment = (cflp_assignment *) malloc(sizeof(cflp_assignment));
+	assignment->instance = instance;
+	assignment->facilities = (size_t *) malloc(sizeof(size_t) * customers);
+	assignment->next = (size_t *) malloc(sizeof(size_t) * customers);
+	assignment->prev = (size_t *) malloc(sizeof(size_t) * customers);
+	assignment->first = (size_t *) malloc(sizeof(size_t) * facilities);
+	assignment->bandwidths = (cflp_val *) calloc(facilities, sizeof(cflp_val));
+	assignment->counts = (cflp_val *) calloc(facilities, sizeof(cflp_val));
+	assignment->open = (size_t *) malloc(sizeof(size_t) * facilities);
+	assignment->open_pos = (size_t *) malloc(sizeof(size_t) * facilities);
+	assignment->num_open = 0;
+	assignment->objective = 0;
+	assignment->violations = 0;
+	assignment->log_capacity = 64;
+	assignment->log = (cflp_assignment_step *) malloc(sizeof(cflp_assignment_step) * assignment->log_capacity);
+	assignment->log_len = 0;
+	assignment->close_customers = (size_t *) malloc(sizeof(size_t) * customers);
+	assignment->close_targets = (size_t *) malloc(sizeof(size_t) * customers);
+	assignment->extra_bandwidths = (cflp_val *) calloc(facilities, sizeof(cflp_val));
+	assignment->extra_counts = (cflp_val *) calloc(facilities, sizeof(cflp_val));
+	assignment->extra_facilities = (size_t *) malloc(sizeof(size_t) * facilities);
+	for (size_t k = 0; k < num_facilities; k++)
+	{
+		assignment->first[k] = CFLP_ASSIGNMENT_NONE;
+		assignment->open_pos[k] = CFLP_ASSIGNMENT_NONE;
+	}
+	for (size_t i = 0; i < num_customers; i++)
+	{
+		cflp_assignment_link(assignment, i, solution[i]);
+	}
+	for (size_t k = 0; k < num_facilities; k++)
+	{
+		assignment->violations += cflp_assignment_facility_violated(assignment, k);
+	}
+	return assignment;
+}
+
+cflp_val cflp_assignment_objective(cflp_assignment *assignment)
+{
+	return assignment->objective;
+}
+
+size_t cflp_assignment_violations(cflp_assignment *assignment)
+{
+	return assignment->violations;
+}
+
+const size_t *cflp_assignment_solution(cflp_assignment *assignment)
+{
+	return assignment->facilities;
+}
+
+cflp_val cflp_assignment_move_delta(cflp_assignment *assignment, size_t customer, size_t facility, int *feasible)
+{
+	cflp_instance *instance = assignment->instance;
+	size_t previous = assignment->facilities[customer];
+	if (previous == facility)
+	{
+		if (feasible != NULL)
+		{
+			*feasible = assignment->violations == 0;
+		}
+		return 0;
+	}
+	cflp_val delta = cflp_assignment_costs(instance, facility, customer) - cflp_assignment_costs(instance, previous, customer);
+	if (assignment->counts[previous] == 1)
+	{
+		delta -= instance->fac_opening_costs[previous];
+	}
+	if (assignment->counts[facility] == 0)
+	{
+		delta += instance->fac_opening_costs[facility];
+	}
+	if (feasible != NULL)
+	{
+		cflp_val bandwidth = instance->cus_bandwidths[customer];
+		size_t violations = assignment->violations
+			- cflp_assignment_facility_violated(assignment, previous) - cflp_assignment_facility_violated(assignment, facility)
+			+ cflp_assignment_violated(instance, previous, assignment->bandwidths[previous] - bandwidth, assignment->counts[previous] - 1)
+			+ cflp_assignment_violated(instance, facility, assignment->bandwidths[facility] + bandwidth, assignment->counts[facility] + 1);
+		*feasible = violations == 0;
+	}
+	return delta;
+}
+
+cflp_val cflp_assignment_swap_delta(cflp_assignment *assignment, size_t customer_a, size_t customer_b, int *feasible)
+{
+	cflp_instance *instance = assignment->instance;
+	size_t facility_a = assignment->facilities[customer_a];
+	size_t facility_b = assignment->facilities[customer_b];
+	if (facility_a == facility_b)
+	{
+		if (feasible != NULL)
+		{
+			*feasible = assignment->violations == 0;
+		}
+		return 0;
+	}
+	// the customer counts stay, so do the opened facilities
+	cflp_val delta = cflp_assignment_costs(instance, facility_b, customer_a) + cflp_assignment_costs(instance, facility_a, customer_b)
+		- cflp_assignment_costs(instance, facility_a, customer_a) - cflp_assignment_costs(instance, facility_b, customer_b);
+	if (feasible != NULL)
+	{
+		cflp_val exchanged = instance->cus_bandwidths[customer_b] - instance->cus_bandwidths[customer_a];
+		size_t violations = assignment->violations
+			- cflp_assignment_facility_violated(assignment, facility_a) - cflp_assignment_facility_violated(assignment, facility_b)
+			+ cflp_assignment_violated(instance, facility_a, assignment->bandwidths[facility_a] + exchanged, assignment->counts[facility_a])
+			+ cflp_assignment_violated(instance, facility_b, assignment->bandwidths[facility_b] - exchanged, assignment->counts[facility_b]);
+		*feasible = violations == 0;
+	}
+	return delta;
+}
+
+// fills close_customers and close_targets, returns the number of customers or CFLP_ASSIGNMENT_NONE
+// if no other facility is open
+size_t cflp_assignment_redistribute(cflp_assignment *assignment, size_t facility, cflp_val *delta, size_t *violations)
+{
+	cflp_instance *instance = assignment->instance;
+	*delta = 0;
+	*violations = assignment->violations;
+	if (assignment->counts[facility] == 0)
+	{
+		return 0;
+	}
+	if (assignment->num_open <= 1)
+	{
+		return CFLP_ASSIGNMENT_NONE;
+	}
+	*delta -= instance->fac_opening_costs[facility];
+	*violations -= cflp_assignment_facility_violated(assignment, facility);
+	size_t num = 0;
+	size_t num_extra = 0;
+	for (size_t customer = assignment->first[facility]; customer != CFLP_ASSIGNMENT_NONE; customer = assignment->next[customer])
+	{
+		cflp_val bandwidth = instance->cus_bandwidths[customer];
+		size_t cheapest = CFLP_ASSIGNMENT_NONE;
+		size_t fitting = CFLP_ASSIGNMENT_NONE;
+		cflp_val cheapest_costs = CFLP_VAL_MAX;
+		cflp_val fitting_costs = CFLP_VAL_MAX;
+		for (size_t k = 0; k < assignment->num_open; k++)
+		{
+			size_t other = assignment->open[k];
+			if (other == facility)
+			{
+				continue;
+			}
+			cflp_val costs = cflp_assignment_costs(instance, other, customer);
+			if (costs < cheapest_costs)
+			{
+				cheapest = other;
+				cheapest_costs = costs;
+			}
+			if (costs < fitting_costs && !cflp_assignment_violated(instance, other,
+				assignment->bandwidths[other] + assignment->extra_bandwidths[other] + bandwidth,
+				assignment->counts[other] + assignment->extra_counts[other] + 1))
+			{
+				fitting = other;
+				fitting_costs = costs;
+			}
+		}
+		size_t target = fitting != CFLP_ASSIGNMENT_NONE ? fitting : cheapest;
+		if (assignment->extra_counts[target] == 0)
+		{
+			assignment->extra_facilities[num_extra++] = target;
+		}
+		assignment->extra_bandwidths[target] += bandwidth;
+		assignment->extra_counts[target]++;
+		*delta += cflp_assignment_costs(instance, target, customer) - cflp_assignment_costs(instance, facility, customer);
+		assignment->close_customers[num] = customer;
+		assignment->close_targets[num] = target;
+		num++;
+	}
+	for (size_t k = 0; k < num_extra; k++)
+	{
+		size_t other = assignment->extra_facilities[k];
+		*violations -= cflp_assignment_facility_violated(assignment, other);
+		*violations += cflp_assignment_violated(instance, other, assignment->bandwidths[other] + assignment->extra_bandwidths[other],
+												assignment->counts[other] + assignment->extra_counts[other]);
+		assignment->extra_bandwidths[other] = 0;
+		assignment->extra_counts[other] = 0;
+	}
+	return num;
+}
+
+cflp_val cflp_assignment_close_delta(cflp_assignment *assignment, size_t facility, int *feasible)
+{
+	cflp_val delta;
+	size_t violations;
+	if (cflp_assignment_redistribute(assignment, facility, &delta, &violations) == CFLP_ASSIGNMENT_NONE)
+	{
+		if (feasible != NULL)
+		{
+			*feasible = 0;
+		}
+		return CFLP_VAL_MAX;
+	}
+	if (feasible != NULL)
+	{
+		*feasible = violations == 0;
+	}
+	return delta;
+}
+
+void cflp_assignment_move(cflp_assignment *assignment, size_t customer, size_t facility)
+{
+	if (assignment->facilities[customer] == facility)
+	{
+		return;
+	}
+	if (assignment->log_len == assignment->log_capacity)
+	{
+		assignment->log_capacity *= 2;
+		assignment->log = (cflp_assignment_step *) realloc(assignment->log, sizeof(cflp_assignment_step) * assignment->log_capacity);
+	}
+	assignment->log[assignment->log_len].customer = customer;
+	assignment->log[assignment->log_len].facility = assignment->facilities[customer];
+	assignment->log_len++;
+	cflp_assignment_apply(assignment, customer, facility);
+}
+
+void cflp_assignment_swap(cflp_assignment *assignment, size_t customer_a, size_t customer_b)
+{
+	size_t facility_a = assignment->facilities[customer_a];
+	cflp_assignment_move(assignment, customer_a, assignment->facilities[customer_b]);
+	cflp_assignment_move(assignment, customer_b, facility_a);
+}
+
+int cflp_assignment_close(cflp_assignment *assignment, size_t facility)
+{
+	cflp_val delta;
+	size_t violations;
+	size_t num = cflp_assignment_redistribute(assignment, facility, &delta, &violations);
+	if (num == CFLP_ASSIGNMENT_NONE)
+	{
+		return -1;
+	}
+	for (size_t i = 0; i < num; i++)
+	{
+		cflp_assignment_move(assignment, assignment->close_customers[i], assignment->close_targets[i]);
+	}
+	return 0;
+}
+
+size_t cflp_assignment_mark(cflp_assignment *assignment)
+{
+	return assignment->log_len;
+}
+
+void cflp_assignment_undo(cflp_assignment *assignment, size_t mark)
+{
+	while (assignment->log_len > mark)
+	{
+		assignment->log_len--;
+		cflp_assignment_apply(assignment, assignment->log[assignment->log_len].customer, assignment->log[assignment->log_len].facility);
+	}
+}
+
+void cflp_assignment_commit(cflp_assignment *assignment)
+{
+	assignment->log_len = 0;
+}
+
+void cflp_assignment_free(cflp_assignment *assignment)
+{
+	free(assignment->facilities);
+	free(assignment->next);
+	free(assignment->prev);
+	free(assignment->first);
+	free(assignment->bandwidths);
+	free(assignment->counts);
+	free(assignment->open);
+	free(assignment->open_pos);
+	free(assignment->log);
+	free(assignment->close_customers);
+	free(assignment->close_targets);
+	free(assignment->extra_bandwidths);
+	free(assignment->extra_counts);
+	free(assignment->extra_facilities);
+	free(assignment);
+}
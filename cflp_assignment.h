@@ -0,0 +1,55 @@
+#include <stddef.h>
+#include "cflp_instance.h"
+
+#ifndef __CFLP_ASSIGNMENT_HEADER
+#define __CFLP_ASSIGNMENT_HEADER
+
+// Complete assignment of the customers to facilities with the bandwidth, customer count and opening
+// state of each facility, for local searches. The deltas of moves are answered in O(1) (closing a
+// facility in O(its customers * open facilities)) without changing the assignment; applied moves can
+// be undone. The limits may be violated, the assignment counts the facilities beyond a limit.
+// The instance must not change while an assignment of it exists; one thread at a time.
+typedef struct cflp_assignment_s cflp_assignment;
+
+// takes the facility index per customer, returns NULL with errno EINVAL if the length or an index is wrong
+cflp_assignment *cflp_assignment_create(cflp_instance *instance, const size_t *solution, size_t solution_len);
+
+// costs of the current assignment
+cflp_val cflp_assignment_objective(cflp_assignment *assignment);
+
+// number of facilities beyond the bandwidth or customer limit, 0 if the assignment is a valid solution
+size_t cflp_assignment_violations(cflp_assignment *assignment);
+
+// the facility index per customer
+const size_t *cflp_assignment_solution(cflp_assignment *assignment);
+
+// Cost change of a move; feasible (may be NULL) tells whether no facility would be beyond a limit afterwards.
+
+cflp_val cflp_assignment_move_delta(cflp_assignment *assignment, size_t customer, size_t facility, int *feasible);
+
+cflp_val cflp_assignment_swap_delta(cflp_assignment *assignment, size_t customer_a, size_t customer_b, int *feasible);
+
+// the customers of the facility go one after another to the cheapest other open facility with room
+// left (the cheapest one if none has), CFLP_VAL_MAX if no other facility is open
+cflp_val cflp_assignment_close_delta(cflp_assignment *assignment, size_t facility, int *feasible);
+
+// Applied moves, each one can be undone.
+
+void cflp_assignment_move(cflp_assignment *assignment, size_t customer, size_t facility);
+
+void cflp_assignment_swap(cflp_assignment *assignment, size_t customer_a, size_t customer_b);
+
+// redistributes the customers like cflp_assignment_close_delta(), returns -1 if no other facility is open
+int cflp_assignment_close(cflp_assignment *assignment, size_t facility);
+
+// position in the undo log, cflp_assignment_undo() returns to the state of this position
+size_t cflp_assignment_mark(cflp_assignment *assignment);
+
+void cflp_assignment_undo(cflp_assignment *assignment, size_t mark);
+
+// drops the undo log, the moves so far can not be undone anymore
+void cflp_assignment_commit(cflp_assignment *assignment);
+
+void cflp_assignment_free(cflp_assignment *assignment);
+
+#endif
@@ -0,0 +1,253 @@
+#include "cflp_batch.h"
+#include "cflp_instance_reader.h"
+#include "cflp_solver.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+typedef struct
+{
+	char *path;
+	long long bytes;
+} cflp_batch_job;
+
+typedef struct
+{
+	cflp_batch_job *jobs;
+	size_t num_jobs;
+	size_t capacity;
+} cflp_batch_list;
+
+typedef struct
+{
+	const cflp_batch_options *options;
+	cflp_batch_job *jobs; // the small jobs of the pool
+	size_t num_jobs;
+	size_t next; // next job to take, incremented atomically
+	size_t failed; // incremented atomically
+	pthread_mutex_t mutex; // one output line at a time
+} cflp_batch_pool;
+
+const char *cflp_batch_status_names[] = { "optimal", "feasible", "infeasible", "unknown" };
+
+void cflp_batch_options_init(cflp_batch_options *options)
+{
+	options->threads = 1;
+	options->large_bytes = CFLP_BATCH_DEFAULT_LARGE_BYTES;
+	bnb_options_init(&options->solve);
+	options->output = stdout;
+}
+
+void cflp_batch_add_job(cflp_batch_list *list, const char *path, long long bytes)
+{
+	if (list->num_jobs == list->capacity)
+	{
+		list->capacity = list->capacity * 2 + 16;
+		list->jobs = (cflp_batch_job *) realloc(list->jobs, sizeof(cflp_batch_job) * list->capacity);
+	}
+	list->jobs[list->num_jobs].path = strdup(path);
+	list->jobs[list->num_jobs].bytes = bytes;
+	list->num_jobs++;
+}
+
+int cflp_batch_compare_names(const void *a, const void *b)
+{
+	return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+// adds the regular files of the directory sorted by name, hidden files are skipped
+void cflp_batch_add_directory(cflp_batch_list *list, const char *path)
+{
+	DIR *dir = opendir(path);
+	if (dir == NULL)
+	{
+		return;
+	}
+	char **names = NULL;
+	size_t num_names = 0;
+	size_t capacity = 0;
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL)
+	{
+		if (entry->d_name[0] == '.')
+		{
+			continue;
+		}
+		if (num_names == capacity)
+		{
+			capacity = capacity * 2 + 16;
+			names = (char **) realloc(names, sizeof(char *) * capacity);
+		}
+		names[num_names++] = strdup(entry->d_name);
+	}
+	closedir(dir);
+	qsort(names, num_names, sizeof(char *), cflp_batch_compare_names);
+
+	size_t path_len = strlen(path);
+	for (size_t i = 0; i < num_names; i++)
+	{
+		char *file = (char *) malloc(path_len + strlen(names[i]) + 2);
+		sprintf(file, "%s/%s", path, names[i]);
+		struct stat info;
+		if (stat(file, &info) == 0 && S_ISREG(info.st_mode))
+		{
+			cflp_batch_add_job(list, file, info.st_size);
+		}
+		free(file);
+		free(names[i]);
+	}
+	free(names);
+}
+
+void cflp_batch_solve(cflp_batch_pool *pool, cflp_batch_job *job, buffered_reader **reader, int threads)
+{
+	long long start_us = cflp_stats_now_us();
+	cflp_instance *instance = NULL;
+	if (*reader == NULL)
+	{
+		*reader = buffered_reader_create_path(job->path);
+		if (*reader != NULL)
+		{
+			instance = cflp_instance_reader_read_instance_from(*reader);
+		}
+	}
+	else if (buffered_reader_reopen_path(*reader, job->path) == 0)
+	{
+		instance = cflp_instance_reader_read_instance_from(*reader);
+	}
+	long long load_us = cflp_stats_now_us() - start_us;
+
+	if (instance == NULL)
+	{
+		__atomic_fetch_add(&pool->failed, 1, __ATOMIC_RELAXED);
+		pthread_mutex_lock(&pool->mutex);
+		fprintf(pool->options->output, "%s\terror\t-\t-\t%.3f\t-\n", job->path, load_us / 1000.0);
+		fflush(pool->options->output);
+		pthread_mutex_unlock(&pool->mutex);
+		return;
+	}
+
+	bnb_options options = pool->options->solve;
+	options.threads = threads;
+	cflp_solver *solver = cflp_solver_create(instance);
+	start_us = cflp_stats_now_us();
+	cflp_solver_status status = cflp_solver_solve(solver, &options);
+	long long solve_us = cflp_stats_now_us() - start_us;
+
+	pthread_mutex_lock(&pool->mutex);
+	fprintf(pool->options->output, "%s\t%s\t", job->path, cflp_batch_status_names[status]);
+	if (cflp_solver_get_objective(solver) != CFLP_VAL_INVALID)
+	{
+		fprintf(pool->options->output, "%" CFLP_VAL_FMT "\t", cflp_solver_get_objective(solver));
+	}
+	else
+	{
+		fprintf(pool->options->output, "-\t");
+	}
+	if (cflp_solver_get_lower_bound(solver) != CFLP_VAL_INVALID)
+	{
+		fprintf(pool->options->output, "%" CFLP_VAL_FMT "\t", cflp_solver_get_lower_bound(solver));
+	}
+	else
+	{
+		fprintf(pool->options->output, "-\t");
+	}
+	fprintf(pool->options->output, "%.3f\t%.3f\n", load_us / 1000.0, solve_us / 1000.0);
+	fflush(pool->options->output);
+	pthread_mutex_unlock(&pool->mutex);
+
+	cflp_solver_free(solver);
+	cflp_instance_free(instance);
+}
+
+void *cflp_batch_worker(void *param)
+{
+	cflp_batch_pool *pool = (cflp_batch_pool *) param;
+	buffered_reader *reader = NULL; // the buffers are reused for all instances of this worker
+	size_t index;
+	while ((index = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->num_jobs)
+	{
+		cflp_batch_solve(pool, &pool->jobs[index], &reader, 1);
+	}
+	if (reader != NULL)
+	{
+		buffered_reader_free(reader);
+	}
+	return NULL;
+}
+
+int cflp_batch_compare_jobs_dsc(const void *a, const void *b)
+{
+	long long x = ((const cflp_batch_job *) a)->bytes;
+	long long y = ((const cflp_batch_job *) b)->bytes;
+	return x < y ? 1 : (x > y ? -1 : 0);
+}
+
+size_t cflp_batch_run(const char **paths, size_t num_paths, const cflp_batch_options *options)
+{
+	cflp_batch_list list = { NULL, 0, 0 };
+	for (size_t i = 0; i < num_paths; i++)
+	{
+		struct stat info;
+		if (stat(paths[i], &info) == 0 && S_ISDIR(info.st_mode))
+		{
+			cflp_batch_add_directory(&list, paths[i]);
+		}
+		else
+		{
+			cflp_batch_add_job(&list, paths[i], stat(paths[i], &info) == 0 ? info.st_size : 0);
+		}
+	}
+
+	// the largest instances first, so the last small ones fill the gaps at the end
+	qsort(list.jobs, list.num_jobs, sizeof(cflp_batch_job), cflp_batch_compare_jobs_dsc);
+	int threads = options->threads > 0 ? options->threads : 1;
+
+	cflp_batch_pool pool;
+	pool.options = options;
+	pool.next = 0;
+	pool.failed = 0;
+	pthread_mutex_init(&pool.mutex, NULL);
+
+	// large instances one after another with a parallel search
+	size_t num_large = 0;
+	buffered_reader *reader = NULL;
+	while (num_large < list.num_jobs && list.jobs[num_large].bytes >= options->large_bytes)
+	{
+		cflp_batch_solve(&pool, &list.jobs[num_large], &reader, threads);
+		num_large++;
+	}
+	if (reader != NULL)
+	{
+		buffered_reader_free(reader);
+	}
+
+	// small instances packed on the pool, one thread each
+	pool.jobs = list.jobs + num_large;
+	pool.num_jobs = list.num_jobs - num_large;
+	pthread_t *handles = (pthread_t *) malloc(sizeof(pthread_t) * threads);
+	int started = 0;
+	for (int t = 1; t < threads && (size_t) t < pool.num_jobs; t++)
+	{
+		if (pthread_create(&handles[started], NULL, cflp_batch_worker, &pool) == 0)
+		{
+			started++;
+		}
+	}
+	cflp_batch_worker(&pool);
+	for (int t = 0; t < started; t++)
+	{
+		pthread_join(handles[t], NULL);
+	}
+	free(handles);
+	pthread_mutex_destroy(&pool.mutex);
+
+	for (size_t i = 0; i < list.num_jobs; i++)
+	{
+		free(list.jobs[i].path);
+	}
+	free(list.jobs);
+	return pool.failed;
+}
@@ -0,0 +1,28 @@
+#include <stdio.h>
+#include "cflp.h"
+
+#ifndef __CFLP_BATCH_HEADER
+#define __CFLP_BATCH_HEADER
+
+// instances with larger files are solved one after another with all threads
+#define CFLP_BATCH_DEFAULT_LARGE_BYTES (256 * 1024)
+
+typedef struct
+{
+	// size of the thread pool
+	int threads;
+	// files with at least this many bytes get all threads, the smaller ones are solved in parallel with one thread each
+	long long large_bytes;
+	// options of each solve, threads, callbacks and cancel flag are replaced
+	bnb_options solve;
+	// one line per instance: path, status, objective, lower bound, load and solve time in milliseconds
+	FILE *output;
+} cflp_batch_options;
+
+void cflp_batch_options_init(cflp_batch_options *options);
+
+// solves the instance files and all files of the directories in paths, returns the number of
+// instances that could not be loaded
+size_t cflp_batch_run(const char **paths, size_t num_paths, const cflp_batch_options *options);
+
+#endif
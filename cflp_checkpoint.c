@@ -0,0 +1,334 @@
+#include "cflp_checkpoint.h"
+#include "buffered_reader.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CFLP_CHECKPOINT_MAGIC "CFLPCHECKPOINT 1"
+
+struct cflp_checkpoint_writer_s
+{
+	char *path;
+	cflp_checkpoint *checkpoint;
+	int pending; // the checkpoint is filled and waits for the thread
+	int stop;
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+};
+
+cflp_checkpoint *cflp_checkpoint_create(size_t num_customers)
+{
+	if (num_customers > SIZE_MAX / sizeof(size_t))
+	{
+		errno = ENOMEM;
+		return NULL;
+	}
+	cflp_checkpoint *checkpoint = (cflp_checkpoint *) malloc(sizeof(cflp_checkpoint));
+	if (checkpoint == NULL)
+	{
+		return NULL;
+	}
+	memset(checkpoint, 0, sizeof(cflp_checkpoint));
+	checkpoint->num_customers = num_customers;
+	checkpoint->solution = (size_t *) malloc(sizeof(size_t) * (num_customers > 0 ? num_customers : 1));
+	checkpoint->path = (size_t *) malloc(sizeof(size_t) * (num_customers > 0 ? num_customers : 1));
+	if (checkpoint->solution == NULL || checkpoint->path == NULL)
+	{
+		cflp_checkpoint_free(checkpoint);
+		errno = ENOMEM;
+		return NULL;
+	}
+	checkpoint->incumbent = CFLP_VAL_INVALID;
+	checkpoint->pruned_lower = CFLP_VAL_MAX;
+	return checkpoint;
+}
+
+unsigned long long cflp_checkpoint_hash_values(unsigned long long hash, const cflp_val *values, size_t num)
+{
+	for (size_t i = 0; i < num; i++)
+	{
+		hash ^= (unsigned long long) values[i];
+		hash *= 1099511628211ULL; // FNV-1a on whole numbers
+	}
+	return hash;
+}
+
+unsigned long long cflp_checkpoint_instance_hash(cflp_instance *instance)
+{
+	cflp_val header[5] = { instance->threshold, instance->max_bandwith, instance->distance_costs,
+						   (cflp_val) instance->num_facilities, (cflp_val) instance->num_customers };
+	unsigned long long hash = cflp_checkpoint_hash_values(14695981039346656037ULL, header, 5);
+	hash = cflp_checkpoint_hash_values(hash, instance->fac_max_customers, instance->num_facilities);
+	hash = cflp_checkpoint_hash_values(hash, instance->fac_opening_costs, instance->num_facilities);
+	hash = cflp_checkpoint_hash_values(hash, instance->cus_bandwidths, instance->num_customers);
+	for (size_t i = 0; i < instance->num_customers; i++)
+	{
+		for (size_t k = 0; k < instance->num_facilities; k++)
+		{
+			hash ^= (unsigned long long) CFLP_INSTANCE_DISTANCE(instance, k, i);
+			hash *= 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+void cflp_checkpoint_write_list(FILE *file, const char *name, const size_t *values, size_t num)
+{
+	fprintf(file, "%s %zu", name, num);
+	for (size_t i = 0; i < num; i++)
+	{
+		fprintf(file, " %zu", values[i]);
+	}
+	fprintf(file, "\n");
+}
+
+int cflp_checkpoint_write(const cflp_checkpoint *checkpoint, const char *path)
+{
+	size_t path_len = strlen(path);
+	char *temporary = (char *) malloc(path_len + 5);
+	memcpy(temporary, path, path_len);
+	memcpy(temporary + path_len, ".tmp", 5);
+	FILE *file = fopen(temporary, "w");
+	if (file == NULL)
+	{
+		free(temporary);
+		return -1;
+	}
+	fprintf(file, "%s\n", CFLP_CHECKPOINT_MAGIC);
+	fprintf(file, "instance %llu\n", checkpoint->instance_hash);
+	fprintf(file, "done %d\n", checkpoint->done);
+	fprintf(file, "incumbent %" CFLP_VAL_FMT "\n", checkpoint->incumbent);
+	cflp_checkpoint_write_list(file, "solution", checkpoint->solution, checkpoint->incumbent != CFLP_VAL_INVALID ? checkpoint->num_customers : 0);
+	fprintf(file, "pruned_lower %" CFLP_VAL_FMT "\n", checkpoint->pruned_lower);
+	cflp_checkpoint_write_list(file, "path", checkpoint->path, checkpoint->path_len);
+	fprintf(file, "elapsed_ms %lld\n", checkpoint->elapsed_ms);
+	fprintf(file, "nodes %llu %llu %llu %llu\n", checkpoint->nodes, checkpoint->pruned_bound, checkpoint->pruned_capacity, checkpoint->pruned_theo);
+	int error = fflush(file) != 0 || fsync(fileno(file)) != 0;
+	error |= fclose(file) != 0;
+	if (!error)
+	{
+		error = rename(temporary, path) != 0;
+	}
+	free(temporary);
+	return error ? -1 : 0;
+}
+
+// reads "<name> <count> <values>" into values, which has room for max values
+int cflp_checkpoint_read_list(const char *line, const char *name, size_t *values, size_t max, size_t *num)
+{
+	size_t name_len = strlen(name);
+	if (strncmp(line, name, name_len) != 0 || line[name_len] != ' ')
+	{
+		return 0;
+	}
+	char *end;
+	*num = strtoull(line + name_len, &end, 10);
+	if (*num > max)
+	{
+		return 0;
+	}
+	for (size_t i = 0; i < *num; i++)
+	{
+		const char *begin = end;
+		values[i] = strtoull(begin, &end, 10);
+		if (end == begin)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+cflp_checkpoint *cflp_checkpoint_read(const char *path, size_t num_customers)
+{
+	buffered_reader *reader = buffered_reader_create_path(path);
+	if (reader == NULL)
+	{
+		return NULL;
+	}
+	cflp_checkpoint *checkpoint = NULL;
+	int valid = 0;
+	do
+	{
+		const char *line = buffered_reader_read_line(reader);
+		if (line == NULL || strcmp(line, CFLP_CHECKPOINT_MAGIC) != 0)
+		{
+			break;
+		}
+		unsigned long long instance_hash;
+		int done;
+		cflp_val incumbent;
+		line = buffered_reader_read_line(reader);
+		if (line == NULL || sscanf(line, "instance %llu", &instance_hash) != 1)
+		{
+			break;
+		}
+		line = buffered_reader_read_line(reader);
+		if (line == NULL || sscanf(line, "done %d", &done) != 1)
+		{
+			break;
+		}
+		line = buffered_reader_read_line(reader);
+		if (line == NULL || sscanf(line, "incumbent %" CFLP_VAL_FMT, &incumbent) != 1)
+		{
+			break;
+		}
+		// the solution is empty without incumbent
+		line = buffered_reader_read_line(reader);
+		size_t solution_len;
+		if (line == NULL || sscanf(line, "solution %zu", &solution_len) != 1
+			|| solution_len != (incumbent != CFLP_VAL_INVALID ? num_customers : 0))
+		{
+			break;
+		}
+		checkpoint = cflp_checkpoint_create(num_customers);
+		if (checkpoint == NULL)
+		{
+			break;
+		}
+		checkpoint->instance_hash = instance_hash;
+		checkpoint->done = done;
+		checkpoint->incumbent = incumbent;
+		size_t num;
+		if (!cflp_checkpoint_read_list(line, "solution", checkpoint->solution, solution_len, &num))
+		{
+			break;
+		}
+		line = buffered_reader_read_line(reader);
+		if (line == NULL || sscanf(line, "pruned_lower %" CFLP_VAL_FMT, &checkpoint->pruned_lower) != 1)
+		{
+			break;
+		}
+		line = buffered_reader_read_line(reader);
+		if (line == NULL)
+		{
+			break;
+		}
+		// one facility per depth, the path buffer has room for all customers
+		size_t path_len;
+		if (sscanf(line, "path %zu", &path_len) != 1 || path_len > num_customers)
+		{
+			break;
+		}
+		if (!cflp_checkpoint_read_list(line, "path", checkpoint->path, path_len, &checkpoint->path_len))
+		{
+			break;
+		}
+		line = buffered_reader_read_line(reader);
+		if (line == NULL || sscanf(line, "elapsed_ms %lld", &checkpoint->elapsed_ms) != 1)
+		{
+			break;
+		}
+		line = buffered_reader_read_line(reader);
+		if (line == NULL || sscanf(line, "nodes %llu %llu %llu %llu", &checkpoint->nodes, &checkpoint->pruned_bound,
+								   &checkpoint->pruned_capacity, &checkpoint->pruned_theo) != 4)
+		{
+			break;
+		}
+		valid = 1;
+	} while (0);
+	buffered_reader_free(reader);
+	if (!valid)
+	{
+		if (checkpoint != NULL)
+		{
+			cflp_checkpoint_free(checkpoint);
+		}
+		errno = EINVAL;
+		return NULL;
+	}
+	return checkpoint;
+}
+
+void cflp_checkpoint_free(cflp_checkpoint *checkpoint)
+{
+	free(checkpoint->solution);
+	checkpoint->solution = NULL;
+	free(checkpoint->path);
+	checkpoint->path = NULL;
+	free(checkpoint);
+}
+
+void *cflp_checkpoint_writer_thread(void *param)
+{
+	cflp_checkpoint_writer *writer = (cflp_checkpoint_writer *) param;
+	pthread_mutex_lock(&writer->mutex);
+	while (1)
+	{
+		while (!writer->pending && !writer->stop)
+		{
+			pthread_cond_wait(&writer->cond, &writer->mutex);
+		}
+		if (!writer->pending)
+		{
+			break;
+		}
+		// the search does not touch the checkpoint while it is pending
+		pthread_mutex_unlock(&writer->mutex);
+		if (cflp_checkpoint_write(writer->checkpoint, writer->path) != 0)
+		{
+			perror(writer->path);
+		}
+		pthread_mutex_lock(&writer->mutex);
+		writer->pending = 0;
+		pthread_cond_broadcast(&writer->cond);
+	}
+	pthread_mutex_unlock(&writer->mutex);
+	return NULL;
+}
+
+cflp_checkpoint_writer *cflp_checkpoint_writer_create(const char *path, size_t num_customers)
+{
+	cflp_checkpoint_writer *writer = (cflp_checkpoint_writer *) malloc(sizeof(cflp_checkpoint_writer));
+	writer->path = strdup(path);
+	writer->checkpoint = cflp_checkpoint_create(num_customers);
+	writer->pending = 0;
+	writer->stop = 0;
+	pthread_mutex_init(&writer->mutex, NULL);
+	pthread_cond_init(&writer->cond, NULL);
+	if (pthread_create(&writer->thread, NULL, cflp_checkpoint_writer_thread, writer) != 0)
+	{
+		pthread_cond_destroy(&writer->cond);
+		pthread_mutex_destroy(&writer->mutex);
+		cflp_checkpoint_free(writer->checkpoint);
+		free(writer->path);
+		free(writer);
+		return NULL;
+	}
+	return writer;
+}
+
+cflp_checkpoint *cflp_checkpoint_writer_begin(cflp_checkpoint_writer *writer)
+{
+	pthread_mutex_lock(&writer->mutex);
+	int pending = writer->pending;
+	pthread_mutex_unlock(&writer->mutex);
+	return pending ? NULL : writer->checkpoint;
+}
+
+void cflp_checkpoint_writer_commit(cflp_checkpoint_writer *writer)
+{
+	pthread_mutex_lock(&writer->mutex);
+	writer->pending = 1;
+	pthread_cond_broadcast(&writer->cond);
+	pthread_mutex_unlock(&writer->mutex);
+}
+
+void cflp_checkpoint_writer_free(cflp_checkpoint_writer *writer)
+{
+	pthread_mutex_lock(&writer->mutex);
+	writer->stop = 1;
+	pthread_cond_broadcast(&writer->cond);
+	pthread_mutex_unlock(&writer->mutex);
+	pthread_join(writer->thread, NULL);
+	pthread_cond_destroy(&writer->cond);
+	pthread_mutex_destroy(&writer->mutex);
+	cflp_checkpoint_free(writer->checkpoint);
+	free(writer->path);
+	free(writer);
+}
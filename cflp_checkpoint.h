@@ -0,0 +1,57 @@
+#include <stddef.h>
+#include "cflp_instance.h"
+
+#ifndef __CFLP_CHECKPOINT_HEADER
+#define __CFLP_CHECKPOINT_HEADER
+
+// State of a search that can be continued: the incumbent, the smallest bound of the pruned subtrees
+// and the facility chosen on each depth of the path to the current node of branch(). The subtrees
+// left of the path are done, the ones right of it are still open.
+typedef struct
+{
+	unsigned long long instance_hash; // see cflp_checkpoint_instance_hash()
+	int done; // the search was complete, pruned_lower is the proven bound
+	cflp_val incumbent; // CFLP_VAL_INVALID if none
+	size_t *solution; // of the incumbent, num_customers entries
+	size_t num_customers;
+	cflp_val pruned_lower;
+	size_t *path; // facility per depth
+	size_t path_len;
+	long long elapsed_ms; // search time of all runs
+	unsigned long long nodes;
+	unsigned long long pruned_bound;
+	unsigned long long pruned_capacity;
+	unsigned long long pruned_theo;
+} cflp_checkpoint;
+
+// returns NULL with errno ENOMEM if the arrays can not be allocated
+cflp_checkpoint *cflp_checkpoint_create(size_t num_customers);
+
+// hash of all numbers of the instance, a checkpoint only continues the search on the same instance
+unsigned long long cflp_checkpoint_instance_hash(cflp_instance *instance);
+
+// writes to a temporary file that replaces the path, so a crash leaves the previous checkpoint;
+// returns 0 on success
+int cflp_checkpoint_write(const cflp_checkpoint *checkpoint, const char *path);
+
+// returns NULL with errno if the file is missing, EINVAL if it is malformed or its solution or path
+// does not fit an instance with num_customers customers
+cflp_checkpoint *cflp_checkpoint_read(const char *path, size_t num_customers);
+
+void cflp_checkpoint_free(cflp_checkpoint *checkpoint);
+
+// Writes checkpoints in its own thread, so the search only copies its state
+typedef struct cflp_checkpoint_writer_s cflp_checkpoint_writer;
+
+cflp_checkpoint_writer *cflp_checkpoint_writer_create(const char *path, size_t num_customers);
+
+// returns the checkpoint to fill, NULL while the previous one is still written
+cflp_checkpoint *cflp_checkpoint_writer_begin(cflp_checkpoint_writer *writer);
+
+// hands the filled checkpoint of cflp_checkpoint_writer_begin() to the writer thread
+void cflp_checkpoint_writer_commit(cflp_checkpoint_writer *writer);
+
+// waits for the pending checkpoint and stops the thread
+void cflp_checkpoint_writer_free(cflp_checkpoint_writer *writer);
+
+#endif
@@ -0,0 +1,148 @@
+#include "cflp_evaluator.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+struct cflp_evaluator_s
+{
+	cflp_instance *instance;
+	uint64_t *opened; // bit set of the facilities of the current solution
+	cflp_val *bandwidths; // used bandwidth per facility
+	cflp_val *customers; // connected customers per facility
+	size_t *touched; // facilities of the current solution, only their entries are reset
+	size_t *indices; // per customer the position of its distance in the matrix
+	size_t capacity; // customers the indices have room for
+};
+
+cflp_evaluator *cflp_evaluator_create(cflp_instance *instance)
+{
+	size_t num_facilities = instance->num_facilities > 0 ? instance->num_facilities : 1;
+	cflp_evaluator *evaluator = (cflp_evaluator *) malloc(sizeof(cflp_evaluator));
+	evaluator->instance = instance;
+	evaluator->opened = (uint64_t *) calloc((num_facilities + 63) / 64, sizeof(uint64_t));
+	evaluator->bandwidths = (cflp_val *) calloc(num_facilities, sizeof(cflp_val));
+	evaluator->customers = (cflp_val *) calloc(num_facilities, sizeof(cflp_val));
+	evaluator->touched = (size_t *) malloc(sizeof(size_t) * (num_facilities + 1)); // one spare entry for the branch-free append
+	evaluator->capacity = instance->num_customers > 0 ? instance->num_customers : 1;
+	evaluator->indices = (size_t *) malloc(sizeof(size_t) * evaluator->capacity);
+	return evaluator;
+}
+
+// Sum of the distances at the indices. The positions are computed beforehand, so the loads do not
+// depend on each other; four sums keep several of them in flight and let the compiler use gather
+// instructions where the target has them (e.g. -mavx2).
+#define DEFINE_GATHER(NAME, TYPE) \
+cflp_val NAME(const TYPE *distances, const size_t *indices, size_t num) \
+{ \
+	cflp_val sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0; \
+	size_t i = 0; \
+	for (; i + 4 <= num; i += 4) \
+	{ \
+		sum0 += distances[indices[i]]; \
+		sum1 += distances[indices[i + 1]]; \
+		sum2 += distances[indices[i + 2]]; \
+		sum3 += distances[indices[i + 3]]; \
+	} \
+	for (; i < num; i++) \
+	{ \
+		sum0 += distances[indices[i]]; \
+	} \
+	return sum0 + sum1 + sum2 + sum3; \
+}
+
+DEFINE_GATHER(cflp_evaluator_gather, cflp_distance)
+DEFINE_GATHER(cflp_evaluator_gather16, cflp_distance16)
+
+cflp_solution_check cflp_evaluator_evaluate_one(cflp_evaluator *evaluator, const size_t *solution, cflp_val *objective)
+{
+	cflp_instance *instance = evaluator->instance;
+	size_t num_facilities = instance->num_facilities;
+	size_t num_customers = instance->num_customers;
+	cflp_solution_check result = CFLP_SOLUTION_VALID;
+	size_t num_touched = 0;
+	cflp_val opening_costs = 0;
+	size_t i = 0;
+	for (; i < num_customers; i++)
+	{
+		size_t facility = solution[i];
+		if (facility >= num_facilities)
+		{
+			result = result == CFLP_SOLUTION_VALID ? CFLP_SOLUTION_FACILITY : result;
+			break;
+		}
+		evaluator->indices[i] = i * num_facilities + facility;
+		// no branch on the opened bit, candidate solutions of heuristics open facilities in no predictable order
+		uint64_t word = evaluator->opened[facility >> 6];
+		uint64_t opened = (word >> (facility & 63)) & 1;
+		evaluator->opened[facility >> 6] = word | (1ULL << (facility & 63));
+		evaluator->touched[num_touched] = facility;
+		num_touched += 1 - opened;
+		opening_costs += instance->fac_opening_costs[facility] & ((cflp_val) opened - 1);
+		cflp_val bandwidth = evaluator->bandwidths[facility] += instance->cus_bandwidths[i];
+		cflp_val customers = ++evaluator->customers[facility];
+		if (result == CFLP_SOLUTION_VALID)
+		{
+			if (bandwidth > instance->max_bandwith)
+			{
+				result = CFLP_SOLUTION_BANDWIDTH;
+			}
+			else if (customers > instance->fac_max_customers[facility])
+			{
+				result = CFLP_SOLUTION_CUSTOMERS;
+			}
+		}
+	}
+	for (size_t k = 0; k < num_touched; k++)
+	{
+		size_t facility = evaluator->touched[k];
+		evaluator->opened[facility >> 6] = 0;
+		evaluator->bandwidths[facility] = 0;
+		evaluator->customers[facility] = 0;
+	}
+	if (i < num_customers)
+	{
+		*objective = CFLP_VAL_INVALID;
+		return result;
+	}
+	cflp_val distances = instance->distances16 != NULL
+		? cflp_evaluator_gather16(instance->distances16, evaluator->indices, num_customers)
+		: cflp_evaluator_gather(instance->distances, evaluator->indices, num_customers);
+	*objective = opening_costs + distances * instance->distance_costs;
+	return result;
+}
+
+size_t cflp_evaluator_evaluate(cflp_evaluator *evaluator, const size_t *solutions, size_t num_solutions,
+							   cflp_solution_check *checks, cflp_val *objectives)
+{
+	size_t num_customers = evaluator->instance->num_customers;
+	if (num_customers > evaluator->capacity)
+	{
+		evaluator->capacity = num_customers;
+		evaluator->indices = (size_t *) realloc(evaluator->indices, sizeof(size_t) * evaluator->capacity);
+	}
+	size_t num_valid = 0;
+	for (size_t s = 0; s < num_solutions; s++)
+	{
+		cflp_val objective;
+		cflp_solution_check check = cflp_evaluator_evaluate_one(evaluator, solutions + s * num_customers, &objective);
+		num_valid += check == CFLP_SOLUTION_VALID;
+		if (checks != NULL)
+		{
+			checks[s] = check;
+		}
+		if (objectives != NULL)
+		{
+			objectives[s] = objective;
+		}
+	}
+	return num_valid;
+}
+
+void cflp_evaluator_free(cflp_evaluator *evaluator)
+{
+	free(evaluator->opened);
+	free(evaluator->bandwidths);
+	free(evaluator->customers);
+	free(evaluator->touched);
+	free(evaluator->indices);
+	free(evaluator);
+}
@@ -0,0 +1,26 @@
+#include <stddef.h>
+#include "cflp_instance.h"
+
+#ifndef __CFLP_EVALUATOR_HEADER
+#define __CFLP_EVALUATOR_HEADER
+
+// Checks and scores many solutions of one instance (e.g. the candidates of a heuristic). The scratch
+// space is allocated once and only the entries of the facilities a solution uses are reset, so a
+// solution costs O(customers) regardless of the number of facilities. An evaluator may only be used
+// by one thread at a time, create one per thread.
+typedef struct cflp_evaluator_s cflp_evaluator;
+
+// the instance has to outlive the evaluator; customers may be added in between, facilities not
+cflp_evaluator *cflp_evaluator_create(cflp_instance *instance);
+
+// solutions holds num_solutions solutions one after another, each with the facility index of every
+// customer of the instance. checks receives the first violation of each solution in customer order
+// (like cflp_instance_check_solution()), objectives its costs; costs are also calculated for solutions
+// beyond the limits, CFLP_VAL_INVALID only for a facility index out of range. Both may be NULL.
+// Returns the number of valid solutions.
+size_t cflp_evaluator_evaluate(cflp_evaluator *evaluator, const size_t *solutions, size_t num_solutions,
+							   cflp_solution_check *checks, cflp_val *objectives);
+
+void cflp_evaluator_free(cflp_evaluator *evaluator);
+
+#endif
@@ -1,19 +1,64 @@
 #include "cflp_instance.h"
+#include "cflp_memory.h"
 #include <string.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-#ifndef min
-#define min(a,b) \
-   ({ __typeof__ (a) _a = (a); \
-       __typeof__ (b) _b = (b); \
-     _a < _b ? _a : _b; })
+int cflp_instance_fits_distance(cflp_val distance)
+{
+	return distance >= INT32_MIN && distance <= INT32_MAX;
+}
+
+int cflp_instance_fits_distance16(cflp_val distance)
+{
+#ifdef CFLP_DISTANCES_32
+	(void) distance;
+	return 0;
+#else
+	return distance >= 0 && distance <= UINT16_MAX;
 #endif
+}
+
+// takes the distances over, narrowed to 16 bits if all of them fit
+void cflp_instance_store_distances(cflp_instance *instance, cflp_distance *distances)
+{
+	size_t num = instance->num_facilities * instance->num_customers;
+	size_t i = 0;
+	while (i < num && cflp_instance_fits_distance16(distances[i]))
+	{
+		i++;
+	}
+	if (i < num)
+	{
+		instance->distances = distances;
+		instance->distances16 = NULL;
+		return;
+	}
+	instance->distances16 = (cflp_distance16*)cflp_memory_alloc(num * sizeof(cflp_distance16));
+	for (i = 0; i < num; i++)
+	{
+		instance->distances16[i] = (cflp_distance16) distances[i];
+	}
+	instance->distances = NULL;
+	cflp_memory_free(distances);
+}
 
 cflp_instance *cflp_instance_create(cflp_val threshold, cflp_val max_bandwith, cflp_val *fac_max_customers,
 									cflp_val distance_costs, cflp_val *fac_opening_costs, cflp_val *cus_bandwidths,
 									cflp_val *distances, size_t fac_len, size_t cus_len)
 {
+	for (size_t i = 0; i < fac_len * cus_len; i++)
+	{
+		if (!cflp_instance_fits_distance(distances[i]))
+		{
+			errno = ERANGE;
+			return NULL;
+		}
+	}
 	cflp_instance *instance = (cflp_instance *) malloc(sizeof(cflp_instance));
 
 	instance->threshold = threshold;
@@ -31,15 +76,161 @@ cflp_instance *cflp_instance_create(cflp_val threshold, cflp_val max_bandwith, c
 	instance->cus_bandwidths = (cflp_val*)malloc(cus_len * sizeof(cflp_val));
 	memcpy(instance->cus_bandwidths, cus_bandwidths, cus_len * sizeof(cflp_val));
 
-	instance->distances = (cflp_val*)malloc(fac_len * cus_len * sizeof(cflp_val));
-	memcpy(instance->distances, distances, fac_len * cus_len * sizeof(cflp_val));
+	cflp_distance *stored = (cflp_distance*)cflp_memory_alloc(fac_len * cus_len * sizeof(cflp_distance));
+	for (size_t i = 0; i < fac_len * cus_len; i++)
+	{
+		stored[i] = (cflp_distance) distances[i];
+	}
+	cflp_instance_store_distances(instance, stored);
+	instance->mapping = NULL;
+	instance->mapping_len = 0;
+	instance->mapping_path = NULL;
+
+	return instance;
+}
+
+cflp_instance *cflp_instance_create_owned(cflp_val threshold, cflp_val max_bandwith, cflp_val *fac_max_customers,
+										  cflp_val distance_costs, cflp_val *fac_opening_costs, cflp_val *cus_bandwidths,
+										  cflp_distance *distances, size_t fac_len, size_t cus_len)
+{
+	cflp_instance *instance = (cflp_instance *) malloc(sizeof(cflp_instance));
+
+	instance->threshold = threshold;
+	instance->max_bandwith = max_bandwith;
+	instance->distance_costs = distance_costs;
+	instance->num_customers = cus_len;
+	instance->num_facilities = fac_len;
+	instance->fac_max_customers = fac_max_customers;
+	instance->fac_opening_costs = fac_opening_costs;
+	instance->cus_bandwidths = cus_bandwidths;
+	cflp_instance_store_distances(instance, distances);
+	instance->mapping = NULL;
+	instance->mapping_len = 0;
+	instance->mapping_path = NULL;
+
+	return instance;
+}
+
+void *cflp_instance_copy_array(const void *array, size_t size)
+{
+	void *copy = malloc(size > 0 ? size : 1);
+	memcpy(copy, array, size);
+	return copy;
+}
+
+void *cflp_instance_copy_distances(const void *distances, size_t size)
+{
+	void *copy = cflp_memory_alloc(size);
+	memcpy(copy, distances, size);
+	return copy;
+}
+
+// maps the file of the distances, returns 0 on success or -1 with errno
+int cflp_instance_map_distances(cflp_instance *instance, const char *path, size_t offset)
+{
+	size_t num = instance->num_facilities * instance->num_customers;
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return -1;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+	size_t size = (size_t) st.st_size;
+	if (offset % sizeof(cflp_distance) != 0 || size < offset || (size - offset) / sizeof(cflp_distance) < num || size == 0)
+	{
+		close(fd);
+		errno = EINVAL;
+		return -1;
+	}
+	void *mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED)
+	{
+		return -1;
+	}
+	instance->mapping = mapping;
+	instance->mapping_len = size;
+	instance->mapping_path = strdup(path);
+	instance->distances = (cflp_distance *) ((char *) mapping + offset);
+	instance->distances16 = NULL;
+	return 0;
+}
+
+cflp_instance *cflp_instance_create_mapped(cflp_val threshold, cflp_val max_bandwith, cflp_val *fac_max_customers,
+										   cflp_val distance_costs, cflp_val *fac_opening_costs, cflp_val *cus_bandwidths,
+										   const char *path, size_t offset, size_t fac_len, size_t cus_len)
+{
+	cflp_instance *instance = (cflp_instance *) malloc(sizeof(cflp_instance));
+
+	instance->threshold = threshold;
+	instance->max_bandwith = max_bandwith;
+	instance->distance_costs = distance_costs;
+	instance->num_customers = cus_len;
+	instance->num_facilities = fac_len;
+	if (cflp_instance_map_distances(instance, path, offset) != 0)
+	{
+		free(instance);
+		return NULL;
+	}
+
+	instance->fac_max_customers = (cflp_val*)cflp_instance_copy_array(fac_max_customers, fac_len * sizeof(cflp_val));
+	instance->fac_opening_costs = (cflp_val*)cflp_instance_copy_array(fac_opening_costs, fac_len * sizeof(cflp_val));
+	instance->cus_bandwidths = (cflp_val*)cflp_instance_copy_array(cus_bandwidths, cus_len * sizeof(cflp_val));
 
 	return instance;
 }
 
+int cflp_instance_is_mapped(cflp_instance *instance)
+{
+	return instance->mapping != NULL;
+}
+
+void cflp_instance_distances_sequential(cflp_instance *instance)
+{
+	if (instance->mapping != NULL)
+	{
+		madvise(instance->mapping, instance->mapping_len, MADV_SEQUENTIAL);
+	}
+}
+
+void cflp_instance_distances_release(cflp_instance *instance)
+{
+	if (instance->mapping != NULL)
+	{
+		// the pages stay in the page cache, the search faults the rows it reads back in
+		madvise(instance->mapping, instance->mapping_len, MADV_DONTNEED);
+		madvise(instance->mapping, instance->mapping_len, MADV_NORMAL);
+	}
+}
+
 cflp_instance *cflp_instance_copy(cflp_instance *other)
 {
-	return cflp_instance_create(other->threshold, other->max_bandwith, other->fac_max_customers, other->distance_costs, other->fac_opening_costs, other->cus_bandwidths, other->distances, other->num_facilities, other->num_customers);
+	cflp_instance *instance = (cflp_instance *) malloc(sizeof(cflp_instance));
+	*instance = *other;
+	size_t num_distances = other->num_facilities * other->num_customers;
+	instance->fac_max_customers = (cflp_val*)cflp_instance_copy_array(other->fac_max_customers, other->num_facilities * sizeof(cflp_val));
+	instance->fac_opening_costs = (cflp_val*)cflp_instance_copy_array(other->fac_opening_costs, other->num_facilities * sizeof(cflp_val));
+	instance->cus_bandwidths = (cflp_val*)cflp_instance_copy_array(other->cus_bandwidths, other->num_customers * sizeof(cflp_val));
+	if (other->mapping != NULL)
+	{
+		// shares the pages of the page cache instead of a second matrix in memory
+		size_t offset = (size_t) ((char *) other->distances - (char *) other->mapping);
+		if (cflp_instance_map_distances(instance, other->mapping_path, offset) != 0)
+		{
+			instance->mapping = NULL;
+			instance->mapping_path = NULL;
+			instance->distances = (cflp_distance*)cflp_instance_copy_distances(other->distances, num_distances * sizeof(cflp_distance));
+		}
+		return instance;
+	}
+	instance->distances = other->distances != NULL ? (cflp_distance*)cflp_instance_copy_distances(other->distances, num_distances * sizeof(cflp_distance)) : NULL;
+	instance->distances16 = other->distances16 != NULL ? (cflp_distance16*)cflp_instance_copy_distances(other->distances16, num_distances * sizeof(cflp_distance16)) : NULL;
+	return instance;
 }
 
 size_t cflp_instance_get_num_customers(cflp_instance *instance)
@@ -59,7 +250,7 @@ cflp_val cflp_instance_bandwidth_of(cflp_instance *instance, size_t customer_idx
 
 cflp_val cflp_instance_distance(cflp_instance *instance, size_t facility_idx, size_t customer_idx)
 {
-	return instance->distances[CFLP_INSTANCE_DISTANCE_INDEX(facility_idx, customer_idx, instance->num_facilities, instance->num_customers)];
+	return CFLP_INSTANCE_DISTANCE(instance, facility_idx, customer_idx);
 }
 
 cflp_val cflp_instance_opening_costs_for(cflp_instance *instance, size_t facility_idx)
@@ -77,35 +268,140 @@ cflp_val cflp_instance_get_threshold(cflp_instance *instance)
 	return instance->threshold;
 }
 
-cflp_val cflp_instance_calc_objective_value(cflp_instance *instance, size_t *solution, size_t solution_len)
+void cflp_instance_set_bandwidth(cflp_instance *instance, size_t customer_idx, cflp_val bandwidth)
 {
-	size_t opened_facilities_len = cflp_instance_get_num_facilities(instance) * sizeof(cflp_val);
-	size_t* opened_facilities = (size_t*)malloc(opened_facilities_len * sizeof(size_t));
-	memset(opened_facilities, 0, opened_facilities_len * sizeof(size_t));
+	instance->cus_bandwidths[customer_idx] = bandwidth;
+}
 
+void cflp_instance_set_opening_costs(cflp_instance *instance, size_t facility_idx, cflp_val opening_costs)
+{
+	instance->fac_opening_costs[facility_idx] = opening_costs;
+}
+
+void cflp_instance_set_max_customers(cflp_instance *instance, size_t facility_idx, cflp_val max_customers)
+{
+	instance->fac_max_customers[facility_idx] = max_customers;
+}
+
+size_t cflp_instance_add_customer(cflp_instance *instance, cflp_val bandwidth, const cflp_val *distances)
+{
+	if (instance->mapping != NULL)
+	{
+		errno = EROFS;
+		return (size_t) -1;
+	}
+	int narrow = instance->distances16 != NULL;
+	for (size_t k = 0; k < instance->num_facilities; k++)
+	{
+		if (!cflp_instance_fits_distance(distances[k]))
+		{
+			errno = ERANGE;
+			return (size_t) -1;
+		}
+		narrow = narrow && cflp_instance_fits_distance16(distances[k]);
+	}
+	size_t num_distances = instance->num_facilities * instance->num_customers;
+	if (instance->distances16 != NULL && !narrow)
+	{
+		// the new customer is too far away for 16 bits
+		instance->distances = (cflp_distance*)cflp_memory_alloc((num_distances + instance->num_facilities) * sizeof(cflp_distance));
+		for (size_t i = 0; i < num_distances; i++)
+		{
+			instance->distances[i] = instance->distances16[i];
+		}
+		cflp_memory_free(instance->distances16);
+		instance->distances16 = NULL;
+	}
+	size_t customer_idx = instance->num_customers++;
+	instance->cus_bandwidths = (cflp_val*)realloc(instance->cus_bandwidths, sizeof(cflp_val) * instance->num_customers);
+	instance->cus_bandwidths[customer_idx] = bandwidth;
+	if (narrow)
+	{
+		instance->distances16 = (cflp_distance16*)cflp_memory_realloc(instance->distances16, sizeof(cflp_distance16) * (num_distances + instance->num_facilities));
+	}
+	else
+	{
+		instance->distances = (cflp_distance*)cflp_memory_realloc(instance->distances, sizeof(cflp_distance) * (num_distances + instance->num_facilities));
+	}
+	for (size_t k = 0; k < instance->num_facilities; k++)
+	{
+		size_t index = CFLP_INSTANCE_DISTANCE_INDEX(k, customer_idx, instance->num_facilities, instance->num_customers);
+		if (narrow)
+		{
+			instance->distances16[index] = (cflp_distance16) distances[k];
+		}
+		else
+		{
+			instance->distances[index] = (cflp_distance) distances[k];
+		}
+	}
+	return customer_idx;
+}
+
+cflp_solution_check cflp_instance_check_solution(cflp_instance *instance, const size_t *solution, size_t solution_len)
+{
+	if (solution_len != instance->num_customers)
+	{
+		return CFLP_SOLUTION_LENGTH;
+	}
+	cflp_val* used_bandwidths = (cflp_val*)calloc(instance->num_facilities, sizeof(cflp_val));
+	cflp_val* connected_customers = (cflp_val*)calloc(instance->num_facilities, sizeof(cflp_val));
+	cflp_solution_check result = CFLP_SOLUTION_VALID;
+	for (size_t i = 0; i < solution_len; i++)
+	{
+		size_t fIdx = solution[i];
+		if (fIdx >= instance->num_facilities)
+		{
+			result = CFLP_SOLUTION_FACILITY;
+			break;
+		}
+		used_bandwidths[fIdx] += instance->cus_bandwidths[i];
+		if (used_bandwidths[fIdx] > instance->max_bandwith)
+		{
+			result = CFLP_SOLUTION_BANDWIDTH;
+			break;
+		}
+		connected_customers[fIdx] += 1;
+		if (connected_customers[fIdx] > instance->fac_max_customers[fIdx])
+		{
+			result = CFLP_SOLUTION_CUSTOMERS;
+			break;
+		}
+	}
+	free(used_bandwidths);
+	free(connected_customers);
+	return result;
+}
+
+cflp_val cflp_instance_calc_objective_value(cflp_instance *instance, size_t *solution, size_t solution_len)
+{
 	if (solution_len != cflp_instance_get_num_customers(instance))
 	{
 		errno = EINVAL;
 		return CFLP_VAL_INVALID;
 	}
+	// one bit per facility
+	uint64_t* opened_facilities = (uint64_t*)calloc((instance->num_facilities + 63) / 64 + 1, sizeof(uint64_t));
 
 	cflp_val sum_costs = CFLP_VAL_EMPTY;
-	for (size_t i = 0; i < min(solution_len, cflp_instance_get_num_customers(instance)); i++)
+	for (size_t i = 0; i < solution_len; i++)
 	{
-		if (solution[i] < 0)
-			continue;
-
-		if (!opened_facilities[solution[i]])
+		size_t facility = solution[i];
+		if (facility >= instance->num_facilities)
+		{
+			free(opened_facilities);
+			errno = EINVAL;
+			return CFLP_VAL_INVALID;
+		}
+		if (!(opened_facilities[facility / 64] & (1ULL << (facility % 64))))
 		{
-			sum_costs += instance->fac_opening_costs[solution[i]];
-			opened_facilities[solution[i]] = 1;
+			sum_costs += instance->fac_opening_costs[facility];
+			opened_facilities[facility / 64] |= 1ULL << (facility % 64);
 		}
-		sum_costs += instance->distance_costs * cflp_instance_distance(instance, solution[i], i);
+		sum_costs += instance->distance_costs * cflp_instance_distance(instance, facility, i);
 	}
 
 	free(opened_facilities);
-	opened_facilities = NULL;
-
 	return sum_costs;
 }
 
@@ -120,8 +416,20 @@ void cflp_instance_free(cflp_instance *instance)
 	free(instance->cus_bandwidths);
 	instance->cus_bandwidths = NULL;
 
-	free(instance->distances);
+	if (instance->mapping != NULL)
+	{
+		munmap(instance->mapping, instance->mapping_len);
+		instance->mapping = NULL;
+		free(instance->mapping_path);
+		instance->mapping_path = NULL;
+		instance->distances = NULL;
+	}
+
+	cflp_memory_free(instance->distances);
 	instance->distances = NULL;
 
+	cflp_memory_free(instance->distances16);
+	instance->distances16 = NULL;
+
 	free(instance);
 }
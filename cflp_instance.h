@@ -1,15 +1,36 @@
 #include "types.h"
 #include <limits.h>
+#include <stdint.h>
 
 #ifndef __CFLP_INSTANCE_HEADER
 #define __CFLP_INSTANCE_HEADER
 
 #define CFLP_VAL_INVALID (-1)
 #define CFLP_VAL_EMPTY (0)
-#define CFLP_VAL_MAX (INT_MAX)
 #define CFLP_INSTANCE_DISTANCE_INDEX(facility_idx, customer_idx, num_facilities, num_customers) (customer_idx * num_facilities + facility_idx)
 
+// Costs, bounds and the other numbers of an instance. The sums of costs of large instances overflow an
+// int, so they are 64 bits unless built with CFLP_VAL_32. Print them with "%" CFLP_VAL_FMT.
+#ifdef CFLP_VAL_32
 typedef int cflp_val;
+#define CFLP_VAL_MAX (INT_MAX)
+#define CFLP_VAL_FMT "d"
+#else
+typedef long long cflp_val;
+#define CFLP_VAL_MAX (LLONG_MAX)
+#define CFLP_VAL_FMT "lld"
+#endif
+
+// Storage of a distance. The matrix is narrowed to 16 bits when all distances fit (unless built with
+// CFLP_DISTANCES_32), which halves the largest part of an instance.
+typedef int32_t cflp_distance;
+typedef uint16_t cflp_distance16;
+
+// distance of the facility to the customer as cflp_val, whatever the storage
+#define CFLP_INSTANCE_DISTANCE(instance, facility_idx, customer_idx) \
+	((instance)->distances16 != NULL \
+		? (cflp_val) (instance)->distances16[(customer_idx) * (instance)->num_facilities + (facility_idx)] \
+		: (cflp_val) (instance)->distances[(customer_idx) * (instance)->num_facilities + (facility_idx)])
 
 struct cflp_instance_s
 {
@@ -26,16 +47,49 @@ struct cflp_instance_s
 	cflp_val* cus_bandwidths;
 	size_t num_facilities;
 
-	// facilities [facility_idx] * customers [customer_idx]
-	cflp_val* distances; // CFLP_INSTANCE_DISTANCE_INDEX(facility_idx, customer_idx, num_facilities, num_customers)
+	// facilities [facility_idx] * customers [customer_idx], CFLP_INSTANCE_DISTANCE_INDEX(facility_idx, customer_idx, num_facilities, num_customers)
+	// in one of the arrays, the other one is NULL; read them with CFLP_INSTANCE_DISTANCE()
+	cflp_distance* distances;
+	cflp_distance16* distances16;
+
+	// the file mapping the distances point into for instances of cflp_instance_create_mapped(), else NULL
+	void* mapping;
+	size_t mapping_len;
+	char* mapping_path;
 };
 
 typedef struct cflp_instance_s cflp_instance;
 
+// returns NULL with errno ERANGE if a distance does not fit into a cflp_distance
 cflp_instance *cflp_instance_create(cflp_val threshold, cflp_val max_bandwith, cflp_val *fac_max_customers,
 									cflp_val distance_costs, cflp_val *fac_opening_costs, cflp_val *cus_bandwidths,
 									cflp_val *distances, size_t fac_len, size_t cus_len);
 
+// like cflp_instance_create() but takes the malloc()ed arrays (the distances of cflp_memory_alloc()) over
+// instead of copying them, they are freed by cflp_instance_free() (the distances right away if they are narrowed)
+cflp_instance *cflp_instance_create_owned(cflp_val threshold, cflp_val max_bandwith, cflp_val *fac_max_customers,
+										  cflp_val distance_costs, cflp_val *fac_opening_costs, cflp_val *cus_bandwidths,
+										  cflp_distance *distances, size_t fac_len, size_t cus_len);
+
+// Out-of-core instance: the distances stay in the file at path, from offset on as native int32_t
+// customer by customer (the binary format of cflp_instance_reader.h), and are mapped read-only instead
+// of loaded, so the page cache holds only the rows in use. The other arrays are copied. Returns NULL
+// with errno EINVAL if the file is too short, or the errno of open() or mmap(). The file must not
+// change while the instance exists.
+cflp_instance *cflp_instance_create_mapped(cflp_val threshold, cflp_val max_bandwith, cflp_val *fac_max_customers,
+										   cflp_val distance_costs, cflp_val *fac_opening_costs, cflp_val *cus_bandwidths,
+										   const char *path, size_t offset, size_t fac_len, size_t cus_len);
+
+// 1 if the distances are mapped from a file
+int cflp_instance_is_mapped(cflp_instance *instance);
+
+// read-ahead hints for one pass over all distances of a mapped instance (e.g. the preprocessing),
+// released drops the pages of the pass from the process; both do nothing for instances in memory
+void cflp_instance_distances_sequential(cflp_instance *instance);
+
+void cflp_instance_distances_release(cflp_instance *instance);
+
+// a copy of a mapped instance maps the same file again
 cflp_instance *cflp_instance_copy(cflp_instance *other);
 
 size_t cflp_instance_get_num_customers(cflp_instance *instance);
@@ -52,6 +106,32 @@ cflp_val cflp_instance_max_customers_for(cflp_instance *instance, size_t facilit
 
 cflp_val cflp_instance_get_threshold(cflp_instance *instance);
 
+// deltas, only while no search runs on the instance
+
+void cflp_instance_set_bandwidth(cflp_instance *instance, size_t customer_idx, cflp_val bandwidth);
+
+void cflp_instance_set_opening_costs(cflp_instance *instance, size_t facility_idx, cflp_val opening_costs);
+
+void cflp_instance_set_max_customers(cflp_instance *instance, size_t facility_idx, cflp_val max_customers);
+
+// appends a customer with its distance to each facility, returns its index or (size_t) -1 with errno
+// ERANGE if a distance does not fit into a cflp_distance (EROFS for mapped instances)
+size_t cflp_instance_add_customer(cflp_instance *instance, cflp_val bandwidth, const cflp_val *distances);
+
+typedef enum
+{
+	CFLP_SOLUTION_VALID,
+	CFLP_SOLUTION_LENGTH, // not one facility per customer
+	CFLP_SOLUTION_FACILITY, // invalid facility index
+	CFLP_SOLUTION_BANDWIDTH, // a facility exceeds the max bandwidth
+	CFLP_SOLUTION_CUSTOMERS // a facility has too many customers
+} cflp_solution_check;
+
+// checks the facility index per customer against the limits of the instance
+cflp_solution_check cflp_instance_check_solution(cflp_instance *instance, const size_t *solution, size_t solution_len);
+
+// returns CFLP_VAL_INVALID with errno EINVAL if the length or a facility index is wrong,
+// see cflp_evaluator.h for many solutions
 cflp_val cflp_instance_calc_objective_value(cflp_instance *instance, size_t *solution, size_t solution_len);
 
 void cflp_instance_free(cflp_instance *instance);
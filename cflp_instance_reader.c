@@ -1,7 +1,11 @@
 #include "cflp_instance_reader.h"
 #include "buffered_reader.h"
+#include "cflp_memory.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <sys/stat.h>
 
 int cflp_instance_reader_whitespace(char c)
 {
@@ -36,7 +40,7 @@ const char *cflp_instance_reader_read_line(buffered_reader *reader)
 	return line;
 }
 
-int cflp_instance_reader_read_int(buffered_reader *reader, const char *prefix)
+cflp_val cflp_instance_reader_read_int(buffered_reader *reader, const char *prefix)
 {
 	const char* line = cflp_instance_reader_read_line(reader);
 	if (line == NULL)
@@ -53,11 +57,11 @@ int cflp_instance_reader_read_int(buffered_reader *reader, const char *prefix)
 	{
 		return -1;
 	}
-	return atoi(line + prefix_len);
+	return atoll(line + prefix_len);
 }
 
 
-int* cflp_instance_reader_fill_int_list(const char* line, size_t line_len, int* array, size_t num)
+cflp_val* cflp_instance_reader_fill_int_list(const char* line, size_t line_len, cflp_val* array, size_t num)
 {
 	block_buffer *buffer = block_buffer_create();
 	int number = 0;
@@ -75,7 +79,7 @@ int* cflp_instance_reader_fill_int_list(const char* line, size_t line_len, int*
 					error = 1;
 					break;
 				}
-				array[number_pos++] = atoi(num_c);
+				array[number_pos++] = atoll(num_c);
 				block_buffer_clear(&buffer);
 				number = 0;
 			}
@@ -102,7 +106,7 @@ int* cflp_instance_reader_fill_int_list(const char* line, size_t line_len, int*
 	return array;
 }
 
-int *cflp_instance_reader_read_int_list(buffered_reader *reader, const char *prefix, size_t num)
+cflp_val *cflp_instance_reader_read_int_list(buffered_reader *reader, const char *prefix, size_t num)
 {
 	const char* line = cflp_instance_reader_read_line(reader);
 	if (line == NULL)
@@ -121,8 +125,8 @@ int *cflp_instance_reader_read_int_list(buffered_reader *reader, const char *pre
 	}
 	line += prefix_len;
 	line_len -= prefix_len;
-	int* array = (int*)malloc(sizeof(int) * num);
-	int* result = cflp_instance_reader_fill_int_list(line, line_len, array, num);
+	cflp_val* array = (cflp_val*)malloc(sizeof(cflp_val) * num);
+	cflp_val* result = cflp_instance_reader_fill_int_list(line, line_len, array, num);
 	if (result == NULL)
 	{
 		free(array);
@@ -132,47 +136,64 @@ int *cflp_instance_reader_read_int_list(buffered_reader *reader, const char *pre
 }
 
 
-int cflp_instance_reader_read_int_array(buffered_reader *reader, int *bandwidths, int *distances, int num_facilities,
-										int num_customers)
+// parses a customer line "bandwidth; distance per facility" into row, returns 0 on errors
+int cflp_instance_reader_read_row(buffered_reader *reader, cflp_val *bandwidth, cflp_val *row, int num_facilities)
 {
-	for (int i = 0; i < num_customers; i++)
+	const char* line = cflp_instance_reader_read_line(reader);
+	if (line == NULL)
 	{
-		const char* line = cflp_instance_reader_read_line(reader);
-		if (line == NULL)
-		{
-			return 0;
-		}
-		size_t linelen = strlen(line);
-		block_buffer *buffer = block_buffer_create();
-		int error = 1;
-		for (size_t k = 0; k < linelen; k++)
+		return 0;
+	}
+	size_t linelen = strlen(line);
+	block_buffer *buffer = block_buffer_create();
+	int error = 1;
+	for (size_t k = 0; k < linelen; k++)
+	{
+		if (line[k] == ';')
 		{
-			if (line[k] == ';')
-			{
-				const char* num = block_buffer_generate(buffer);
-				bandwidths[i] = atoi(num);
+			const char* num = block_buffer_generate(buffer);
+			*bandwidth = atoll(num);
 
-				int* res = cflp_instance_reader_fill_int_list(line + k + 1, linelen - k - 1, distances + num_facilities * i, num_facilities);
+			cflp_val* res = cflp_instance_reader_fill_int_list(line + k + 1, linelen - k - 1, row, num_facilities);
 
-				if (res != NULL)
+			error = res == NULL; // too few or too many distances
+			for (int j = 0; j < num_facilities && !error; j++)
+			{
+				if (row[j] < INT32_MIN || row[j] > INT32_MAX)
 				{
-					error = 0;
+					error = 1; // does not fit into a cflp_distance
+					break;
 				}
-				error = 0;
-				break;
-			}
-			else
-			{
-				block_buffer_append_character(buffer, line[k]);
 			}
+			break;
 		}
-		block_buffer_free(buffer);
-		buffer = NULL;
-		if (error)
+		else
 		{
+			block_buffer_append_character(buffer, line[k]);
+		}
+	}
+	block_buffer_free(buffer);
+	buffer = NULL;
+	return !error;
+}
+
+int cflp_instance_reader_read_int_array(buffered_reader *reader, cflp_val *bandwidths, cflp_distance *distances, int num_facilities,
+										int num_customers)
+{
+	cflp_val *row = (cflp_val *) malloc(sizeof(cflp_val) * num_facilities);
+	for (int i = 0; i < num_customers; i++)
+	{
+		if (!cflp_instance_reader_read_row(reader, &bandwidths[i], row, num_facilities))
+		{
+			free(row);
 			return 0;
 		}
+		for (int j = 0; j < num_facilities; j++)
+		{
+			distances[(size_t) num_facilities * i + j] = (cflp_distance) row[j];
+		}
 	}
+	free(row);
 	return 1;
 }
 
@@ -193,51 +214,94 @@ cflp_instance *cflp_instance_reader_read_instance(const char *path)
 		return NULL;
 	}
 
-	int* max_customers = NULL;
-	int* opening_costs = NULL;
-	int* bandwidths = NULL;
-	int* distances = NULL;
-	cflp_instance *result = NULL;
+	cflp_instance *result = cflp_instance_reader_read_instance_from(reader);
+	buffered_reader_free(reader);
+	return result;
+}
 
+// the lines of a text instance before the customers
+typedef struct
+{
+	cflp_val threshold;
+	cflp_val max_bandwidth;
+	cflp_val distance_costs;
+	int num_facilities;
+	int num_customers;
+	cflp_val* max_customers;
+	cflp_val* opening_costs;
+} cflp_instance_reader_header;
+
+// returns 0 on errors, the lists are only allocated on success
+int cflp_instance_reader_read_header(buffered_reader *reader, cflp_instance_reader_header *header)
+{
+	header->max_customers = NULL;
+	header->opening_costs = NULL;
 	do
 	{
-		int threshold = cflp_instance_reader_read_int(reader, "THRESHOLD:");
-		if (threshold <= 0)
+		header->threshold = cflp_instance_reader_read_int(reader, "THRESHOLD:");
+		if (header->threshold <= 0)
+		{
+			break;
+		}
+		header->num_facilities = cflp_instance_reader_read_int(reader, "FACILITIES:");
+		if (header->num_facilities <= 0)
 		{
 			break;
 		}
-		int num_facilities = cflp_instance_reader_read_int(reader, "FACILITIES:");
-		if (num_facilities <= 0)
+		header->num_customers = cflp_instance_reader_read_int(reader, "CUSTOMERS:");
+		if (header->num_customers <= 0)
 		{
 			break;
 		}
-		int num_customers = cflp_instance_reader_read_int(reader, "CUSTOMERS:");
-		if (num_customers <= 0)
+		header->max_bandwidth = cflp_instance_reader_read_int(reader, "MAXBANDWIDTH:");
+		if (header->max_bandwidth <= 0)
 		{
 			break;
 		}
-		int max_bandwidth = cflp_instance_reader_read_int(reader, "MAXBANDWIDTH:");
-		if (max_bandwidth <= 0)
+		header->max_customers = cflp_instance_reader_read_int_list(reader, "MAXCUSTOMERS:", header->num_facilities);
+		if (header->max_customers == NULL)
 		{
 			break;
 		}
-		max_customers = cflp_instance_reader_read_int_list(reader, "MAXCUSTOMERS:", num_facilities);
-		if (max_customers == NULL)
+		header->distance_costs = cflp_instance_reader_read_int(reader, "DISTANCECOSTS:");
+		if (header->distance_costs <= 0)
 		{
 			break;
 		}
-		int distance_costs = cflp_instance_reader_read_int(reader, "DISTANCECOSTS:");
-		if (distance_costs <= 0)
+		header->opening_costs = cflp_instance_reader_read_int_list(reader, "OPENINGCOSTS:", header->num_facilities);
+		if (header->opening_costs == NULL)
 		{
 			break;
 		}
-		opening_costs = cflp_instance_reader_read_int_list(reader, "OPENINGCOSTS:", num_facilities);
-		if (opening_costs == NULL)
+		return 1;
+	} while (0);
+
+	free(header->max_customers);
+	header->max_customers = NULL;
+	return 0;
+}
+
+cflp_instance *cflp_instance_reader_read_instance_from(buffered_reader *reader)
+{
+	cflp_val* max_customers = NULL;
+	cflp_val* opening_costs = NULL;
+	cflp_val* bandwidths = NULL;
+	cflp_distance* distances = NULL;
+	cflp_instance *result = NULL;
+
+	do
+	{
+		cflp_instance_reader_header header;
+		if (!cflp_instance_reader_read_header(reader, &header))
 		{
 			break;
 		}
+		max_customers = header.max_customers;
+		opening_costs = header.opening_costs;
+		int num_facilities = header.num_facilities;
+		int num_customers = header.num_customers;
 
-		distances = (cflp_val*)malloc(sizeof(cflp_val) * num_facilities * num_customers);
+		distances = (cflp_distance*)cflp_memory_alloc(sizeof(cflp_distance) * (size_t) num_facilities * num_customers);
 		bandwidths = (cflp_val*)malloc(sizeof(cflp_val) * num_customers);
 		
 		int res = cflp_instance_reader_read_int_array(reader, bandwidths, distances, num_facilities, num_customers);
@@ -246,7 +310,11 @@ cflp_instance *cflp_instance_reader_read_instance(const char *path)
 			break;
 		}
 
-		result = cflp_instance_create(threshold, max_bandwidth, max_customers, distance_costs, opening_costs, bandwidths, distances, num_facilities, num_customers);
+		result = cflp_instance_create_owned(header.threshold, header.max_bandwidth, max_customers, header.distance_costs, opening_costs, bandwidths, distances, num_facilities, num_customers);
+		max_customers = NULL;
+		opening_costs = NULL;
+		bandwidths = NULL;
+		distances = NULL;
 
 	} while (0);
 
@@ -256,10 +324,304 @@ cflp_instance *cflp_instance_reader_read_instance(const char *path)
 	opening_costs = NULL;
 	if (bandwidths != NULL) free(bandwidths);
 	bandwidths = NULL;
-	if (distances != NULL) free(distances);
+	cflp_memory_free(distances);
 	distances = NULL;
 
+	return result;
+}
+
+cflp_instance *cflp_instance_reader_read_memory(const char *data, size_t data_len)
+{
+	if (data_len == 0)
+	{
+		return NULL;
+	}
+	FILE *file = fmemopen((void *) data, data_len, "r");
+	if (file == NULL)
+	{
+		return NULL;
+	}
+	buffered_reader *reader = buffered_reader_create_file(file);
+	if (reader == NULL)
+	{
+		fclose(file);
+		return NULL;
+	}
+	cflp_instance *result = cflp_instance_reader_read_instance_from(reader);
 	buffered_reader_free(reader);
-	
 	return result;
 }
+
+cflp_val *cflp_instance_reader_binary_array(const char **data, const char *end, size_t num)
+{
+	if ((size_t) (end - *data) / sizeof(int32_t) < num)
+	{
+		return NULL;
+	}
+	cflp_val *array = (cflp_val *) malloc(sizeof(cflp_val) * (num > 0 ? num : 1));
+	for (size_t i = 0; i < num; i++)
+	{
+		int32_t value;
+		memcpy(&value, *data, sizeof(int32_t));
+		array[i] = value;
+		*data += sizeof(int32_t);
+	}
+	return array;
+}
+
+// the distances are stored with the width of the file
+cflp_distance *cflp_instance_reader_binary_distances(const char **data, const char *end, size_t num)
+{
+	if ((size_t) (end - *data) / sizeof(int32_t) < num)
+	{
+		return NULL;
+	}
+	cflp_distance *array = (cflp_distance *) cflp_memory_alloc(sizeof(cflp_distance) * num);
+	memcpy(array, *data, sizeof(int32_t) * num);
+	*data += sizeof(int32_t) * num;
+	return array;
+}
+
+cflp_instance *cflp_instance_reader_read_binary(const char *data, size_t data_len)
+{
+	const char *end = data + data_len;
+	size_t magic_len = strlen(CFLP_INSTANCE_BINARY_MAGIC);
+	if (data_len < magic_len || memcmp(data, CFLP_INSTANCE_BINARY_MAGIC, magic_len) != 0)
+	{
+		return NULL;
+	}
+	data += magic_len;
+	cflp_val *header = cflp_instance_reader_binary_array(&data, end, 5);
+	if (header == NULL)
+	{
+		return NULL;
+	}
+	cflp_val threshold = header[0];
+	cflp_val max_bandwidth = header[1];
+	cflp_val distance_costs = header[2];
+	cflp_val num_facilities = header[3];
+	cflp_val num_customers = header[4];
+	free(header);
+	if (threshold <= 0 || max_bandwidth <= 0 || distance_costs <= 0 || num_facilities <= 0 || num_customers <= 0)
+	{
+		return NULL;
+	}
+
+	cflp_val *max_customers = cflp_instance_reader_binary_array(&data, end, num_facilities);
+	cflp_val *opening_costs = max_customers != NULL ? cflp_instance_reader_binary_array(&data, end, num_facilities) : NULL;
+	cflp_val *bandwidths = opening_costs != NULL ? cflp_instance_reader_binary_array(&data, end, num_customers) : NULL;
+	cflp_distance *distances = bandwidths != NULL ? cflp_instance_reader_binary_distances(&data, end, (size_t) num_facilities * num_customers) : NULL;
+	if (distances == NULL || data != end)
+	{
+		free(max_customers);
+		free(opening_costs);
+		free(bandwidths);
+		cflp_memory_free(distances);
+		return NULL;
+	}
+	return cflp_instance_create_owned(threshold, max_bandwidth, max_customers, distance_costs, opening_costs, bandwidths, distances, num_facilities, num_customers);
+}
+
+// reads num native 32 bit integers of a binary instance, returns a malloc()ed array or NULL
+cflp_val *cflp_instance_reader_file_array(FILE *file, size_t num)
+{
+	int32_t *values = (int32_t *) malloc(sizeof(int32_t) * (num > 0 ? num : 1));
+	if (fread(values, sizeof(int32_t), num, file) != num)
+	{
+		free(values);
+		return NULL;
+	}
+	cflp_val *array = (cflp_val *) malloc(sizeof(cflp_val) * (num > 0 ? num : 1));
+	for (size_t i = 0; i < num; i++)
+	{
+		array[i] = values[i];
+	}
+	free(values);
+	return array;
+}
+
+cflp_instance *cflp_instance_reader_map_binary(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		return NULL;
+	}
+	size_t magic_len = strlen(CFLP_INSTANCE_BINARY_MAGIC);
+	char magic[8];
+	cflp_val *header = NULL;
+	cflp_val *max_customers = NULL;
+	cflp_val *opening_costs = NULL;
+	cflp_val *bandwidths = NULL;
+	cflp_instance *result = NULL;
+	do
+	{
+		if (fread(magic, 1, magic_len, file) != magic_len || memcmp(magic, CFLP_INSTANCE_BINARY_MAGIC, magic_len) != 0)
+		{
+			break;
+		}
+		header = cflp_instance_reader_file_array(file, 5);
+		if (header == NULL || header[0] <= 0 || header[1] <= 0 || header[2] <= 0 || header[3] <= 0 || header[4] <= 0)
+		{
+			break;
+		}
+		size_t num_facilities = (size_t) header[3];
+		size_t num_customers = (size_t) header[4];
+		max_customers = cflp_instance_reader_file_array(file, num_facilities);
+		opening_costs = max_customers != NULL ? cflp_instance_reader_file_array(file, num_facilities) : NULL;
+		bandwidths = opening_costs != NULL ? cflp_instance_reader_file_array(file, num_customers) : NULL;
+		if (bandwidths == NULL)
+		{
+			break;
+		}
+		size_t offset = magic_len + sizeof(int32_t) * (5 + 2 * num_facilities + num_customers);
+		struct stat st;
+		if (fstat(fileno(file), &st) != 0 || (size_t) st.st_size != offset + sizeof(int32_t) * num_facilities * num_customers)
+		{
+			break;
+		}
+		result = cflp_instance_create_mapped(header[0], header[1], max_customers, header[2], opening_costs, bandwidths,
+											 path, offset, num_facilities, num_customers);
+	} while (0);
+	fclose(file);
+	free(header);
+	free(max_customers);
+	free(opening_costs);
+	free(bandwidths);
+	return result;
+}
+
+// writes num values as native 32 bit integers, returns 0 on errors
+int cflp_instance_reader_write_array(FILE *file, const cflp_val *array, size_t num)
+{
+	for (size_t i = 0; i < num; i++)
+	{
+		if (array[i] < INT32_MIN || array[i] > INT32_MAX)
+		{
+			errno = ERANGE;
+			return 0;
+		}
+		int32_t value = (int32_t) array[i];
+		if (fwrite(&value, sizeof(int32_t), 1, file) != 1)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int cflp_instance_reader_convert_binary(const char *text_path, const char *binary_path)
+{
+	buffered_reader *reader = buffered_reader_create_path(text_path);
+	if (reader == NULL)
+	{
+		return -1;
+	}
+	cflp_instance_reader_header header;
+	if (!cflp_instance_reader_read_header(reader, &header))
+	{
+		buffered_reader_free(reader);
+		errno = EINVAL;
+		return -1;
+	}
+	size_t path_len = strlen(binary_path);
+	char *temporary = (char *) malloc(path_len + 5);
+	memcpy(temporary, binary_path, path_len);
+	memcpy(temporary + path_len, ".tmp", 5);
+	size_t num_facilities = (size_t) header.num_facilities;
+	size_t num_customers = (size_t) header.num_customers;
+	cflp_val *bandwidths = (cflp_val *) malloc(sizeof(cflp_val) * num_customers);
+	cflp_val *row = (cflp_val *) malloc(sizeof(cflp_val) * num_facilities);
+	FILE *file = fopen(temporary, "wb");
+	int error = file == NULL;
+	if (!error)
+	{
+		// the bandwidths come before the distances, they are written when all rows are read
+		cflp_val numbers[5] = { header.threshold, header.max_bandwidth, header.distance_costs, header.num_facilities, header.num_customers };
+		long bandwidths_pos = (long) (strlen(CFLP_INSTANCE_BINARY_MAGIC) + sizeof(int32_t) * (5 + 2 * num_facilities));
+		error = fwrite(CFLP_INSTANCE_BINARY_MAGIC, 1, strlen(CFLP_INSTANCE_BINARY_MAGIC), file) != strlen(CFLP_INSTANCE_BINARY_MAGIC)
+			|| !cflp_instance_reader_write_array(file, numbers, 5)
+			|| !cflp_instance_reader_write_array(file, header.max_customers, num_facilities)
+			|| !cflp_instance_reader_write_array(file, header.opening_costs, num_facilities)
+			|| fseek(file, (long) (sizeof(int32_t) * num_customers), SEEK_CUR) != 0;
+		for (size_t i = 0; i < num_customers && !error; i++)
+		{
+			if (!cflp_instance_reader_read_row(reader, &bandwidths[i], row, (int) num_facilities))
+			{
+				errno = EINVAL;
+				error = 1;
+				break;
+			}
+			error = !cflp_instance_reader_write_array(file, row, num_facilities);
+		}
+		error = error
+			|| fseek(file, bandwidths_pos, SEEK_SET) != 0
+			|| !cflp_instance_reader_write_array(file, bandwidths, num_customers);
+		error |= fclose(file) != 0;
+		error = error || rename(temporary, binary_path) != 0;
+		if (error)
+		{
+			int saved = errno;
+			remove(temporary);
+			errno = saved;
+		}
+	}
+	buffered_reader_free(reader);
+	free(temporary);
+	free(bandwidths);
+	free(row);
+	free(header.max_customers);
+	free(header.opening_costs);
+	return error ? -1 : 0;
+}
+
+size_t *cflp_instance_reader_read_solution(const char *path, size_t *solution_len)
+{
+	buffered_reader *reader = buffered_reader_create_path(path);
+	if (reader == NULL)
+	{
+		return NULL;
+	}
+	size_t *solution = NULL;
+	size_t capacity = 0;
+	size_t len = 0;
+	int error = 0;
+	const char *line;
+	while (!error && (line = cflp_instance_reader_read_line(reader)) != NULL)
+	{
+		const char *ptr = line;
+		while (1)
+		{
+			while (cflp_instance_reader_whitespace(*ptr))
+			{
+				ptr++;
+			}
+			if (*ptr == '\0' || *ptr == '#')
+			{
+				break;
+			}
+			char *end;
+			long long facility = strtoll(ptr, &end, 10);
+			if (end == ptr)
+			{
+				error = 1;
+				break;
+			}
+			if (len == capacity)
+			{
+				capacity = capacity * 2 + 64;
+				solution = (size_t *) realloc(solution, sizeof(size_t) * capacity);
+			}
+			solution[len++] = facility < 0 ? (size_t) -1 : (size_t) facility; // negative: reassigned by the repair
+			ptr = end;
+		}
+	}
+	buffered_reader_free(reader);
+	if (error || len == 0)
+	{
+		free(solution);
+		return NULL;
+	}
+	*solution_len = len;
+	return solution;
+}
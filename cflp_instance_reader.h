@@ -1,3 +1,34 @@
 #include "cflp_instance.h"
 
-cflp_instance *cflp_instance_reader_read_instance(const char *path);
\ No newline at end of file
+#include "buffered_reader.h"
+
+cflp_instance *cflp_instance_reader_read_instance(const char *path);
+
+// reads the next instance from an open reader, e.g. one that is reused for many files (buffered_reader_reopen_path())
+cflp_instance *cflp_instance_reader_read_instance_from(buffered_reader *reader);
+
+// reads a text instance from memory
+cflp_instance *cflp_instance_reader_read_memory(const char *data, size_t data_len);
+
+// binary instances: the magic "CFLB" followed by native 32 bit integers: threshold, max bandwidth, distance costs,
+// number of facilities and customers, max customers and opening costs per facility, bandwidth per customer
+// and the distances customer by customer (like the lines of the text format)
+#define CFLP_INSTANCE_BINARY_MAGIC "CFLB"
+
+cflp_instance *cflp_instance_reader_read_binary(const char *data, size_t data_len);
+
+// maps the distances of a binary instance file instead of loading them (see cflp_instance_create_mapped()),
+// for instances larger than the memory; returns NULL if the file is no complete binary instance
+cflp_instance *cflp_instance_reader_map_binary(const char *path);
+
+// Converts a text instance into a binary one for cflp_instance_reader_map_binary(), one customer line
+// at a time, so the matrix never has to fit into memory. Returns 0 on success or -1 with errno (EINVAL
+// for a malformed instance, ERANGE if a number does not fit into 32 bits). The file is replaced at once.
+int cflp_instance_reader_convert_binary(const char *text_path, const char *binary_path);
+
+// reads a solution file: the facility index per customer, separated by whitespace or line feeds,
+// returns a malloc()ed array or NULL
+size_t *cflp_instance_reader_read_solution(const char *path, size_t *solution_len);
+
+// parses num whitespace separated integers of the line into array, returns NULL if the count differs
+cflp_val* cflp_instance_reader_fill_int_list(const char* line, size_t line_len, cflp_val* array, size_t num);
@@ -0,0 +1,280 @@
+#include "cflp_memory.h"
+#include <errno.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// the header in front of each block keeps it 64 byte aligned
+#define CFLP_MEMORY_HEADER 64
+#define CFLP_MEMORY_HUGE_PAGE (2UL * 1024 * 1024)
+#define CFLP_MEMORY_MASK_BITS (8 * sizeof(unsigned long))
+
+// mbind() of <linux/mempolicy.h>, without a dependency on libnuma
+#define CFLP_MPOL_BIND 2
+#define CFLP_MPOL_INTERLEAVE 3
+#define CFLP_MPOL_MF_MOVE (1 << 1)
+
+typedef struct
+{
+	size_t size;
+	size_t mapped; // length of the mapping starting at the header, 0 for malloc()
+} cflp_memory_header;
+
+cflp_pages cflp_memory_pages = CFLP_PAGES_TRANSPARENT;
+
+void cflp_memory_set_pages(cflp_pages pages)
+{
+	cflp_memory_pages = pages;
+}
+
+cflp_pages cflp_memory_get_pages()
+{
+	return cflp_memory_pages;
+}
+
+cflp_memory_header *cflp_memory_header_of(void *ptr)
+{
+	return (cflp_memory_header *) ((char *) ptr - CFLP_MEMORY_HEADER);
+}
+
+// a mapping whose start and length are multiples of the huge page size, MAP_FAILED on error
+void *cflp_memory_map_aligned(size_t length)
+{
+	size_t padded = length + CFLP_MEMORY_HUGE_PAGE;
+	char *raw = (char *) mmap(NULL, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (raw == MAP_FAILED)
+	{
+		return MAP_FAILED;
+	}
+	char *aligned = (char *) (((uintptr_t) raw + CFLP_MEMORY_HUGE_PAGE - 1) & ~(uintptr_t) (CFLP_MEMORY_HUGE_PAGE - 1));
+	if (aligned > raw)
+	{
+		munmap(raw, aligned - raw);
+	}
+	if (raw + padded > aligned + length)
+	{
+		munmap(aligned + length, raw + padded - (aligned + length));
+	}
+	return aligned;
+}
+
+void *cflp_memory_alloc(size_t size)
+{
+	cflp_pages pages = cflp_memory_pages;
+	cflp_memory_header *header;
+	if (pages == CFLP_PAGES_SMALL || size < CFLP_MEMORY_HUGE_MIN)
+	{
+		header = (cflp_memory_header *) malloc(CFLP_MEMORY_HEADER + size);
+		if (header == NULL)
+		{
+			return NULL;
+		}
+		header->mapped = 0;
+	}
+	else
+	{
+		size_t length = (CFLP_MEMORY_HEADER + size + CFLP_MEMORY_HUGE_PAGE - 1) & ~(CFLP_MEMORY_HUGE_PAGE - 1);
+		void *mapping = MAP_FAILED;
+		if (pages == CFLP_PAGES_EXPLICIT)
+		{
+			mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		}
+		if (mapping == MAP_FAILED)
+		{
+			mapping = cflp_memory_map_aligned(length);
+			if (mapping == MAP_FAILED)
+			{
+				errno = ENOMEM;
+				return NULL;
+			}
+			madvise(mapping, length, MADV_HUGEPAGE); // only a hint, fails without transparent huge pages
+		}
+		header = (cflp_memory_header *) mapping;
+		header->mapped = length;
+	}
+	header->size = size;
+	return (char *) header + CFLP_MEMORY_HEADER;
+}
+
+void *cflp_memory_realloc(void *ptr, size_t size)
+{
+	if (ptr == NULL)
+	{
+		return cflp_memory_alloc(size);
+	}
+	cflp_memory_header *header = cflp_memory_header_of(ptr);
+	if (header->mapped == 0 && (cflp_memory_pages == CFLP_PAGES_SMALL || size < CFLP_MEMORY_HUGE_MIN))
+	{
+		header = (cflp_memory_header *) realloc(header, CFLP_MEMORY_HEADER + size);
+		if (header == NULL)
+		{
+			return NULL;
+		}
+		header->size = size;
+		return (char *) header + CFLP_MEMORY_HEADER;
+	}
+	if (header->mapped > 0 && CFLP_MEMORY_HEADER + size <= header->mapped)
+	{
+		header->size = size;
+		return ptr;
+	}
+	void *moved = cflp_memory_alloc(size);
+	if (moved == NULL)
+	{
+		return NULL;
+	}
+	memcpy(moved, ptr, header->size < size ? header->size : size);
+	cflp_memory_free(ptr);
+	return moved;
+}
+
+void cflp_memory_free(void *ptr)
+{
+	if (ptr == NULL)
+	{
+		return;
+	}
+	cflp_memory_header *header = cflp_memory_header_of(ptr);
+	if (header->mapped > 0)
+	{
+		munmap(header, header->mapped);
+	}
+	else
+	{
+		free(header);
+	}
+}
+
+int cflp_memory_is_mapped(void *ptr)
+{
+	return ptr != NULL && cflp_memory_header_of(ptr)->mapped > 0;
+}
+
+// reads a list like "0-3,8,10-11" of /sys into the set, returns the number of entries or -1
+int cflp_memory_read_list(const char *path, unsigned char *set, int max)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL)
+	{
+		return -1;
+	}
+	char line[4096];
+	char *read = fgets(line, sizeof(line), file);
+	fclose(file);
+	if (read == NULL)
+	{
+		return -1;
+	}
+	memset(set, 0, max);
+	int count = 0;
+	char *pos = line;
+	while (*pos >= '0' && *pos <= '9')
+	{
+		long first = strtol(pos, &pos, 10);
+		long last = first;
+		if (*pos == '-')
+		{
+			last = strtol(pos + 1, &pos, 10);
+		}
+		for (long i = first; i <= last && i < max; i++)
+		{
+			count += !set[i];
+			set[i] = 1;
+		}
+		if (*pos == ',')
+		{
+			pos++;
+		}
+	}
+	return count;
+}
+
+int cflp_memory_nodes(int *nodes, int max)
+{
+	unsigned char set[CFLP_MEMORY_MAX_NODES];
+	if (cflp_memory_read_list("/sys/devices/system/node/has_cpu", set, CFLP_MEMORY_MAX_NODES) <= 0)
+	{
+		if (max > 0)
+		{
+			nodes[0] = 0;
+		}
+		return 1;
+	}
+	int num = 0;
+	for (int i = 0; i < CFLP_MEMORY_MAX_NODES && num < max; i++)
+	{
+		if (set[i])
+		{
+			nodes[num++] = i;
+		}
+	}
+	return num;
+}
+
+int cflp_memory_num_nodes()
+{
+	int nodes[CFLP_MEMORY_MAX_NODES];
+	return cflp_memory_nodes(nodes, CFLP_MEMORY_MAX_NODES);
+}
+
+int cflp_memory_mbind(void *ptr, int mode, const int *nodes, int num_nodes)
+{
+	if (!cflp_memory_is_mapped(ptr))
+	{
+		return 0; // shares its pages with other data of malloc()
+	}
+	unsigned long mask[CFLP_MEMORY_MAX_NODES / CFLP_MEMORY_MASK_BITS];
+	memset(mask, 0, sizeof(mask));
+	for (int i = 0; i < num_nodes; i++)
+	{
+		mask[nodes[i] / CFLP_MEMORY_MASK_BITS] |= 1UL << (nodes[i] % CFLP_MEMORY_MASK_BITS);
+	}
+	cflp_memory_header *header = cflp_memory_header_of(ptr);
+	return syscall(SYS_mbind, header, header->mapped, mode, mask, (unsigned long) CFLP_MEMORY_MAX_NODES + 1, CFLP_MPOL_MF_MOVE) == 0 ? 0 : -1;
+}
+
+int cflp_memory_interleave(void *ptr)
+{
+	int nodes[CFLP_MEMORY_MAX_NODES];
+	int num_nodes = cflp_memory_nodes(nodes, CFLP_MEMORY_MAX_NODES);
+	if (num_nodes <= 1)
+	{
+		return 0;
+	}
+	return cflp_memory_mbind(ptr, CFLP_MPOL_INTERLEAVE, nodes, num_nodes);
+}
+
+int cflp_memory_bind(void *ptr, int node)
+{
+	if (cflp_memory_num_nodes() <= 1)
+	{
+		return 0;
+	}
+	return cflp_memory_mbind(ptr, CFLP_MPOL_BIND, &node, 1);
+}
+
+int cflp_memory_pin_thread(pthread_t thread, int node)
+{
+	char path[128];
+	snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+	unsigned char set[CPU_SETSIZE];
+	if (cflp_memory_read_list(path, set, CPU_SETSIZE) <= 0)
+	{
+		return -1;
+	}
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	for (int i = 0; i < CPU_SETSIZE; i++)
+	{
+		if (set[i])
+		{
+			CPU_SET(i, &cpus);
+		}
+	}
+	return pthread_setaffinity_np(thread, sizeof(cpus), &cpus) == 0 ? 0 : -1;
+}
@@ -0,0 +1,60 @@
+#include <stddef.h>
+#include <pthread.h>
+
+#ifndef __CFLP_MEMORY_HEADER
+#define __CFLP_MEMORY_HEADER
+
+// blocks of at least this size are mapped on their own (and may use huge pages), smaller ones come from malloc()
+#define CFLP_MEMORY_HUGE_MIN (2UL * 1024 * 1024)
+// bit set size for node and cpu lists
+#define CFLP_MEMORY_MAX_NODES 1024
+
+typedef enum
+{
+	CFLP_PAGES_SMALL, // plain malloc(), 4 KiB pages
+	CFLP_PAGES_TRANSPARENT, // 2 MiB aligned mappings with MADV_HUGEPAGE, the kernel decides
+	CFLP_PAGES_EXPLICIT // MAP_HUGETLB from the reserved huge pages (vm.nr_hugepages), transparent if none are left
+} cflp_pages;
+
+// where the read-only search data (the nearest lists and the distances) lives if several search threads
+// run on a machine with more than one NUMA node; a single node ignores it
+typedef enum
+{
+	CFLP_PLACEMENT_LOCAL, // on the node of the thread that first wrote it
+	CFLP_PLACEMENT_INTERLEAVE, // pages spread round robin over all nodes
+	CFLP_PLACEMENT_REPLICATE // a copy of the nearest lists per node, the threads are pinned to the nodes
+} cflp_placement;
+
+// pages of the following cflp_memory_alloc() calls of the process, CFLP_PAGES_TRANSPARENT by default;
+// set it once before loading instances
+void cflp_memory_set_pages(cflp_pages pages);
+
+cflp_pages cflp_memory_get_pages();
+
+// large arrays of the instance and the search, release them with cflp_memory_free()
+void *cflp_memory_alloc(size_t size);
+
+// like realloc(), the content is kept up to the smaller size
+void *cflp_memory_realloc(void *ptr, size_t size);
+
+void cflp_memory_free(void *ptr);
+
+// 1 if the block is mapped on its own, only those can be placed on nodes
+int cflp_memory_is_mapped(void *ptr);
+
+// number of nodes with cpus, 1 without NUMA support
+int cflp_memory_num_nodes();
+
+// the node ids with cpus in ascending order, returns their number
+int cflp_memory_nodes(int *nodes, int max);
+
+// moves the pages of a block round robin onto all nodes, returns 0 on success (also if there is nothing to do)
+int cflp_memory_interleave(void *ptr);
+
+// binds the pages of a block to the node, call it before writing a new block; returns 0 on success
+int cflp_memory_bind(void *ptr, int node);
+
+// restricts the thread to the cpus of the node, returns 0 on success
+int cflp_memory_pin_thread(pthread_t thread, int node);
+
+#endif
@@ -0,0 +1,152 @@
+#include "cflp_pool.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct cflp_pool_s
+{
+	size_t capacity;
+	size_t num_customers;
+	size_t min_distance;
+	size_t size;
+	size_t *slots; // the members by rank, then the free slots
+	size_t *removed; // scratch space of cflp_pool_add()
+	cflp_val *costs; // per slot
+	size_t *solutions; // num_customers per slot
+};
+
+cflp_pool *cflp_pool_create(size_t capacity, size_t num_customers, size_t min_distance)
+{
+	if (capacity == 0 || min_distance == 0)
+	{
+		errno = EINVAL;
+		return NULL;
+	}
+	cflp_pool *pool = (cflp_pool *) malloc(sizeof(cflp_pool));
+	pool->capacity = capacity;
+	pool->num_customers = num_customers;
+	pool->min_distance = min_distance;
+	pool->size = 0;
+	pool->slots = (size_t *) malloc(sizeof(size_t) * capacity);
+	pool->removed = (size_t *) malloc(sizeof(size_t) * capacity);
+	pool->costs = (cflp_val *) malloc(sizeof(cflp_val) * capacity);
+	pool->solutions = (size_t *) malloc(sizeof(size_t) * capacity * (num_customers > 0 ? num_customers : 1));
+	for (size_t i = 0; i < capacity; i++)
+	{
+		pool->slots[i] = i;
+	}
+	return pool;
+}
+
+// whether fewer than min_distance customers are assigned differently, stops at min_distance
+int cflp_pool_closer(const cflp_pool *pool, const size_t *a, const size_t *b)
+{
+	size_t distance = 0;
+	for (size_t i = 0; i < pool->num_customers; i++)
+	{
+		distance += a[i] != b[i];
+		if (distance >= pool->min_distance)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int cflp_pool_add(cflp_pool *pool, cflp_val costs, const size_t *solution)
+{
+	if (costs >= cflp_pool_bound(pool))
+	{
+		return 0;
+	}
+	// the members are sorted, so a closer member that rejects the solution comes before any that it replaces
+	size_t kept = 0;
+	size_t num_removed = 0;
+	for (size_t rank = 0; rank < pool->size; rank++)
+	{
+		size_t slot = pool->slots[rank];
+		if (cflp_pool_closer(pool, pool->solutions + slot * pool->num_customers, solution))
+		{
+			if (pool->costs[slot] <= costs)
+			{
+				return 0;
+			}
+			pool->removed[num_removed++] = slot;
+			continue;
+		}
+		pool->slots[kept++] = slot;
+	}
+	memcpy(pool->slots + kept, pool->removed, sizeof(size_t) * num_removed);
+	pool->size = kept;
+	if (pool->size == pool->capacity)
+	{
+		pool->size--; // the most expensive member
+	}
+
+	size_t slot = pool->slots[pool->size];
+	pool->costs[slot] = costs;
+	memcpy(pool->solutions + slot * pool->num_customers, solution, sizeof(size_t) * pool->num_customers);
+	size_t rank = pool->size++;
+	for (; rank > 0 && pool->costs[pool->slots[rank - 1]] > costs; rank--)
+	{
+		pool->slots[rank] = pool->slots[rank - 1];
+	}
+	pool->slots[rank] = slot;
+	return 1;
+}
+
+int cflp_pool_distinct(const cflp_pool *pool, const size_t *solution)
+{
+	for (size_t rank = 0; rank < pool->size; rank++)
+	{
+		if (cflp_pool_closer(pool, pool->solutions + pool->slots[rank] * pool->num_customers, solution))
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+cflp_val cflp_pool_bound(const cflp_pool *pool)
+{
+	return pool->size == pool->capacity ? pool->costs[pool->slots[pool->size - 1]] : CFLP_VAL_MAX;
+}
+
+size_t cflp_pool_size(const cflp_pool *pool)
+{
+	return pool->size;
+}
+
+size_t cflp_pool_num_customers(const cflp_pool *pool)
+{
+	return pool->num_customers;
+}
+
+size_t cflp_pool_min_distance(const cflp_pool *pool)
+{
+	return pool->min_distance;
+}
+
+cflp_val cflp_pool_costs(const cflp_pool *pool, size_t rank)
+{
+	return pool->costs[pool->slots[rank]];
+}
+
+const size_t *cflp_pool_solution(const cflp_pool *pool, size_t rank)
+{
+	return pool->solutions + pool->slots[rank] * pool->num_customers;
+}
+
+void cflp_pool_clear(cflp_pool *pool)
+{
+	pool->size = 0;
+}
+
+void cflp_pool_free(cflp_pool *pool)
+{
+	free(pool->slots);
+	free(pool->removed);
+	free(pool->costs);
+	free(pool->solutions);
+	free(pool);
+}
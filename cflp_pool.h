@@ -0,0 +1,46 @@
+#include <stddef.h>
+#include "cflp_instance.h"
+
+#ifndef __CFLP_POOL_HEADER
+#define __CFLP_POOL_HEADER
+
+// The capacity cheapest distinct solutions of a search (see bnb_options.pool). Two solutions are
+// distinct if they assign at least min_distance customers to different facilities (Hamming distance).
+// The search fills the pool greedily: each member is the cheapest solution distinct from all cheaper
+// members. All storage is allocated by cflp_pool_create(); one thread at a time.
+typedef struct cflp_pool_s cflp_pool;
+
+// returns NULL with errno EINVAL for a capacity or min_distance of 0
+cflp_pool *cflp_pool_create(size_t capacity, size_t num_customers, size_t min_distance);
+
+// Offers a solution with the facility index per customer, returns 1 if the pool keeps it. A solution
+// closer than min_distance to a member that costs no more is rejected, the closer members that cost
+// more are replaced; a full pool drops its most expensive member. With min_distance > 1 the members
+// depend on the order of the offers: a rejected solution does not come back when the member that
+// rejected it is replaced. Offered from the cheapest to the most expensive one, only distinct ones
+// are kept.
+int cflp_pool_add(cflp_pool *pool, cflp_val costs, const size_t *solution);
+
+// 1 if the solution differs from every member in at least min_distance customers
+int cflp_pool_distinct(const cflp_pool *pool, const size_t *solution);
+
+// costs of the most expensive member of a full pool, CFLP_VAL_MAX while it has room;
+// only cheaper solutions can enter the pool
+cflp_val cflp_pool_bound(const cflp_pool *pool);
+
+size_t cflp_pool_size(const cflp_pool *pool);
+
+size_t cflp_pool_num_customers(const cflp_pool *pool);
+
+size_t cflp_pool_min_distance(const cflp_pool *pool);
+
+// the members from the cheapest (rank 0) to the most expensive one
+cflp_val cflp_pool_costs(const cflp_pool *pool, size_t rank);
+
+const size_t *cflp_pool_solution(const cflp_pool *pool, size_t rank);
+
+void cflp_pool_clear(cflp_pool *pool);
+
+void cflp_pool_free(cflp_pool *pool);
+
+#endif
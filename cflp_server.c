@@ -0,0 +1,620 @@
+#include "cflp_server.h"
+#include "cflp_instance_reader.h"
+#include "block_buffer.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define CFLP_SERVER_QUEUE_LEN 64
+
+typedef struct cflp_server_entry_s
+{
+	unsigned long long hash;
+	size_t bytes;
+	int binary;
+	char *data; // the bytes of the request, a hash match is only a hit if they are equal
+	cflp_instance *instance;
+	bnb_prepared *prepared;
+	int references; // running searches, the entry is only evicted without
+	unsigned long long last_used;
+	struct cflp_server_entry_s *next;
+} cflp_server_entry;
+
+typedef struct
+{
+	const cflp_server_options *options;
+	int listen_fd;
+	int stop;
+	pthread_mutex_t mutex; // the queue and the cache
+	pthread_cond_t not_empty;
+	pthread_cond_t not_full;
+	int queue[CFLP_SERVER_QUEUE_LEN];
+	size_t queue_begin;
+	size_t queue_len;
+	cflp_server_entry *cache;
+	size_t cache_len;
+	unsigned long long clock;
+} cflp_server;
+
+// state of a worker, the buffers are reused for all its connections
+typedef struct
+{
+	cflp_server *server;
+	int fd;
+	char input[4096];
+	size_t input_len;
+	size_t input_pos;
+	block_buffer *line;
+	block_buffer *output;
+	int cancel;
+	// result of the running request
+	cflp_val objective;
+	cflp_val lower_bound;
+} cflp_server_connection;
+
+void cflp_server_options_init(cflp_server_options *options)
+{
+	options->threads = 1;
+	options->cache_entries = CFLP_SERVER_DEFAULT_CACHE_ENTRIES;
+	options->max_request_bytes = CFLP_SERVER_DEFAULT_MAX_REQUEST_BYTES;
+	bnb_options_init(&options->solve);
+}
+
+unsigned long long cflp_server_hash(const char *data, size_t data_len)
+{
+	unsigned long long hash = 14695981039346656037ULL; // FNV-1a
+	for (size_t i = 0; i < data_len; i++)
+	{
+		hash ^= (unsigned char) data[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+// returns the cached instance with a reference, or NULL
+cflp_server_entry *cflp_server_cache_get(cflp_server *server, unsigned long long hash, const char *data, size_t bytes, int binary)
+{
+	cflp_server_entry *found = NULL;
+	pthread_mutex_lock(&server->mutex);
+	for (cflp_server_entry *entry = server->cache; entry != NULL; entry = entry->next)
+	{
+		if (entry->hash == hash && entry->bytes == bytes && entry->binary == binary && memcmp(entry->data, data, bytes) == 0)
+		{
+			entry->references++;
+			entry->last_used = ++server->clock;
+			found = entry;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&server->mutex);
+	return found;
+}
+
+void cflp_server_entry_free(cflp_server_entry *entry)
+{
+	bnb_prepared_free(entry->prepared);
+	cflp_instance_free(entry->instance);
+	free(entry->data);
+	free(entry);
+}
+
+// adds the entry with a reference and evicts the least recently used entries without references
+cflp_server_entry *cflp_server_cache_put(cflp_server *server, cflp_server_entry *added)
+{
+	pthread_mutex_lock(&server->mutex);
+	for (cflp_server_entry *entry = server->cache; entry != NULL; entry = entry->next)
+	{
+		if (entry->hash == added->hash && entry->bytes == added->bytes && entry->binary == added->binary
+			&& memcmp(entry->data, added->data, added->bytes) == 0)
+		{
+			// another worker was faster
+			entry->references++;
+			entry->last_used = ++server->clock;
+			pthread_mutex_unlock(&server->mutex);
+			cflp_server_entry_free(added);
+			return entry;
+		}
+	}
+	added->references = 1;
+	added->last_used = ++server->clock;
+	added->next = server->cache;
+	server->cache = added;
+	server->cache_len++;
+	while (server->cache_len > server->options->cache_entries)
+	{
+		cflp_server_entry **oldest = NULL;
+		for (cflp_server_entry **entry = &server->cache; *entry != NULL; entry = &(*entry)->next)
+		{
+			if ((*entry)->references == 0 && (oldest == NULL || (*entry)->last_used < (*oldest)->last_used))
+			{
+				oldest = entry;
+			}
+		}
+		if (oldest == NULL)
+		{
+			break; // all in use
+		}
+		cflp_server_entry *evicted = *oldest;
+		*oldest = evicted->next;
+		server->cache_len--;
+		cflp_server_entry_free(evicted);
+	}
+	pthread_mutex_unlock(&server->mutex);
+	return added;
+}
+
+void cflp_server_cache_release(cflp_server *server, cflp_server_entry *entry)
+{
+	pthread_mutex_lock(&server->mutex);
+	entry->references--;
+	pthread_mutex_unlock(&server->mutex);
+}
+
+// sends the output buffer and clears it, a failed send cancels the running search
+void cflp_server_flush(cflp_server_connection *connection)
+{
+	size_t length;
+	const char *data = block_buffer_view(connection->output, &length);
+	while (length > 0 && !connection->cancel)
+	{
+		ssize_t sent = send(connection->fd, data, length, MSG_NOSIGNAL);
+		if (sent < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			__atomic_store_n(&connection->cancel, 1, __ATOMIC_RELAXED); // the client is gone
+			break;
+		}
+		data += sent;
+		length -= sent;
+	}
+	block_buffer_clear(&connection->output);
+}
+
+void cflp_server_on_solution(void* context, cflp_val new_upper_bound, size_t* new_solution, size_t new_solution_length)
+{
+	cflp_server_connection *connection = (cflp_server_connection *) context;
+	connection->objective = new_upper_bound;
+	block_buffer_append_string(connection->output, "INCUMBENT ");
+	block_buffer_append_int(connection->output, new_upper_bound);
+	for (size_t i = 0; i < new_solution_length; i++)
+	{
+		block_buffer_append_character(connection->output, ' ');
+		block_buffer_append_int(connection->output, new_solution[i]);
+	}
+	block_buffer_append_character(connection->output, '\n');
+	cflp_server_flush(connection);
+}
+
+void cflp_server_on_lower_bound(void* context, cflp_val new_lower_bound)
+{
+	cflp_server_connection *connection = (cflp_server_connection *) context;
+	connection->lower_bound = new_lower_bound;
+	block_buffer_append_string(connection->output, "BOUND ");
+	block_buffer_append_int(connection->output, new_lower_bound);
+	block_buffer_append_character(connection->output, '\n');
+	cflp_server_flush(connection);
+}
+
+void cflp_server_error(cflp_server_connection *connection, const char *message)
+{
+	block_buffer_append_string(connection->output, "ERROR ");
+	block_buffer_append_string(connection->output, message);
+	block_buffer_append_character(connection->output, '\n');
+	cflp_server_flush(connection);
+}
+
+int cflp_server_fill(cflp_server_connection *connection)
+{
+	ssize_t received;
+	do
+	{
+		received = recv(connection->fd, connection->input, sizeof(connection->input), 0);
+	} while (received < 0 && errno == EINTR);
+	if (received <= 0)
+	{
+		return 0;
+	}
+	connection->input_len = received;
+	connection->input_pos = 0;
+	return 1;
+}
+
+// returns the next line without the line feed, NULL at the end of the connection
+const char *cflp_server_read_line(cflp_server_connection *connection)
+{
+	block_buffer_clear(&connection->line);
+	while (1)
+	{
+		if (connection->input_pos >= connection->input_len && !cflp_server_fill(connection))
+		{
+			return NULL;
+		}
+		char *begin = connection->input + connection->input_pos;
+		char *eol = (char *) memchr(begin, '\n', connection->input_len - connection->input_pos);
+		size_t len = eol != NULL ? (size_t) (eol - begin) : connection->input_len - connection->input_pos;
+		block_buffer_append_memory(connection->line, begin, len);
+		connection->input_pos += len + (eol != NULL ? 1 : 0);
+		if (eol != NULL)
+		{
+			return block_buffer_generate(connection->line);
+		}
+	}
+}
+
+int cflp_server_read_bytes(cflp_server_connection *connection, char *data, size_t data_len)
+{
+	while (data_len > 0)
+	{
+		if (connection->input_pos >= connection->input_len && !cflp_server_fill(connection))
+		{
+			return 0;
+		}
+		size_t len = connection->input_len - connection->input_pos;
+		if (len > data_len)
+		{
+			len = data_len;
+		}
+		memcpy(data, connection->input + connection->input_pos, len);
+		connection->input_pos += len;
+		data += len;
+		data_len -= len;
+	}
+	return 1;
+}
+
+// parses the arguments of a SOLVE line, returns 0 if one is malformed
+int cflp_server_parse_solve(char *arguments, size_t *bytes, int *binary, bnb_options *options)
+{
+	char *save = NULL;
+	char *token = strtok_r(arguments, " ", &save);
+	char *end;
+	if (token == NULL)
+	{
+		return 0;
+	}
+	*bytes = strtoull(token, &end, 10);
+	if (*end != '\0')
+	{
+		return 0;
+	}
+	while ((token = strtok_r(NULL, " ", &save)) != NULL)
+	{
+		if (strcmp(token, "text") == 0)
+		{
+			*binary = 0;
+		}
+		else if (strcmp(token, "binary") == 0)
+		{
+			*binary = 1;
+		}
+		else if (strncmp(token, "time=", 5) == 0)
+		{
+			options->time_limit_ms = strtoll(token + 5, &end, 10);
+		}
+		else if (strncmp(token, "threads=", 8) == 0)
+		{
+			options->threads = strtol(token + 8, &end, 10);
+		}
+		else if (strncmp(token, "target=", 7) == 0)
+		{
+			options->target = strtol(token + 7, &end, 10);
+		}
+		else if (strncmp(token, "abs=", 4) == 0)
+		{
+			options->tolerance_abs = strtol(token + 4, &end, 10);
+		}
+		else if (strncmp(token, "rel=", 4) == 0)
+		{
+			options->tolerance_rel = strtod(token + 4, &end);
+		}
+		else
+		{
+			return 0;
+		}
+		if (*end != '\0')
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+// serves one SOLVE request, returns 0 if the connection has to be closed
+int cflp_server_solve(cflp_server_connection *connection, char *arguments)
+{
+	cflp_server *server = connection->server;
+	size_t bytes = 0;
+	int binary = 0;
+	bnb_options options = server->options->solve;
+	if (!cflp_server_parse_solve(arguments, &bytes, &binary, &options))
+	{
+		cflp_server_error(connection, "malformed SOLVE request");
+		return 0; // the instance bytes can not be skipped
+	}
+	if (options.threads < 1 || options.threads > server->options->threads)
+	{
+		options.threads = server->options->threads;
+	}
+
+	char *data = bytes <= server->options->max_request_bytes ? (char *) malloc(bytes > 0 ? bytes : 1) : NULL;
+	if (data == NULL)
+	{
+		cflp_server_error(connection, "instance too large");
+		return 0; // the instance bytes can not be skipped
+	}
+	if (!cflp_server_read_bytes(connection, data, bytes))
+	{
+		free(data);
+		return 0;
+	}
+	unsigned long long hash = cflp_server_hash(data, bytes);
+	cflp_server_entry *entry = cflp_server_cache_get(server, hash, data, bytes, binary);
+	int cached = entry != NULL;
+	if (entry == NULL)
+	{
+		cflp_instance *instance = binary ? cflp_instance_reader_read_binary(data, bytes) : cflp_instance_reader_read_memory(data, bytes);
+		if (instance == NULL)
+		{
+			free(data);
+			cflp_server_error(connection, "invalid instance");
+			return 1;
+		}
+		entry = (cflp_server_entry *) malloc(sizeof(cflp_server_entry));
+		entry->hash = hash;
+		entry->bytes = bytes;
+		entry->binary = binary;
+		entry->data = data; // kept for the comparison of later requests
+		data = NULL;
+		entry->instance = instance;
+		entry->prepared = bnb_prepare_nearest(instance, options.nearest_len, NULL);
+		if (entry->prepared == NULL)
+		{
+			cflp_instance_free(instance);
+			free(entry->data);
+			free(entry);
+			cflp_server_error(connection, "out of memory");
+			return 1;
+		}
+		entry = cflp_server_cache_put(server, entry);
+	}
+	free(data);
+
+	options.on_solution = cflp_server_on_solution;
+	options.on_lower_bound = cflp_server_on_lower_bound;
+	options.cancel = &connection->cancel;
+	options.stats = NULL;
+	connection->objective = CFLP_VAL_INVALID;
+	connection->lower_bound = CFLP_VAL_INVALID;
+
+	long long start_us = cflp_stats_now_us();
+	bnb_status status = bnb_run_prepared(connection, entry->prepared, &options);
+	long long solve_us = cflp_stats_now_us() - start_us;
+	cflp_server_cache_release(server, entry);
+
+	const char *result;
+	if (status == BNB_COMPLETE)
+	{
+		result = connection->objective != CFLP_VAL_INVALID ? "optimal" : "infeasible";
+	}
+	else
+	{
+		result = connection->objective != CFLP_VAL_INVALID ? "feasible" : "unknown";
+	}
+	block_buffer_append_string(connection->output, "DONE ");
+	block_buffer_append_string(connection->output, result);
+	block_buffer_append_character(connection->output, ' ');
+	if (connection->objective != CFLP_VAL_INVALID)
+	{
+		block_buffer_append_int(connection->output, connection->objective);
+	}
+	else
+	{
+		block_buffer_append_character(connection->output, '-');
+	}
+	block_buffer_append_character(connection->output, ' ');
+	if (connection->lower_bound != CFLP_VAL_INVALID)
+	{
+		block_buffer_append_int(connection->output, connection->lower_bound);
+	}
+	else
+	{
+		block_buffer_append_character(connection->output, '-');
+	}
+	block_buffer_append_string(connection->output, cached ? " 1 " : " 0 ");
+	block_buffer_append_int(connection->output, solve_us / 1000);
+	block_buffer_append_character(connection->output, '\n');
+	cflp_server_flush(connection);
+	return !connection->cancel;
+}
+
+void cflp_server_shutdown(cflp_server *server)
+{
+	pthread_mutex_lock(&server->mutex);
+	server->stop = 1;
+	pthread_cond_broadcast(&server->not_empty);
+	pthread_cond_broadcast(&server->not_full);
+	pthread_mutex_unlock(&server->mutex);
+	shutdown(server->listen_fd, SHUT_RDWR); // wakes up accept()
+}
+
+void cflp_server_serve(cflp_server_connection *connection)
+{
+	connection->input_len = 0;
+	connection->input_pos = 0;
+	connection->cancel = 0;
+	const char *line;
+	while ((line = cflp_server_read_line(connection)) != NULL)
+	{
+		if (strncmp(line, "SOLVE ", 6) == 0)
+		{
+			char *arguments = strdup(line + 6);
+			int keep = cflp_server_solve(connection, arguments);
+			free(arguments);
+			if (!keep)
+			{
+				break;
+			}
+		}
+		else if (strcmp(line, "SHUTDOWN") == 0)
+		{
+			cflp_server_shutdown(connection->server);
+			break;
+		}
+		else if (line[0] != '\0')
+		{
+			cflp_server_error(connection, "unknown request");
+		}
+	}
+	close(connection->fd);
+	connection->fd = -1;
+}
+
+void *cflp_server_worker(void *param)
+{
+	cflp_server *server = (cflp_server *) param;
+	cflp_server_connection connection;
+	connection.server = server;
+	connection.fd = -1;
+	connection.line = block_buffer_create();
+	connection.output = block_buffer_create();
+	while (1)
+	{
+		pthread_mutex_lock(&server->mutex);
+		while (server->queue_len == 0 && !server->stop)
+		{
+			pthread_cond_wait(&server->not_empty, &server->mutex);
+		}
+		if (server->queue_len == 0)
+		{
+			pthread_mutex_unlock(&server->mutex);
+			break;
+		}
+		connection.fd = server->queue[server->queue_begin];
+		server->queue_begin = (server->queue_begin + 1) % CFLP_SERVER_QUEUE_LEN;
+		server->queue_len--;
+		pthread_cond_signal(&server->not_full);
+		pthread_mutex_unlock(&server->mutex);
+		cflp_server_serve(&connection);
+	}
+	block_buffer_free(connection.line);
+	block_buffer_free(connection.output);
+	return NULL;
+}
+
+int cflp_server_run(const char *socket_path, const cflp_server_options *options)
+{
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (strlen(socket_path) >= sizeof(address.sun_path))
+	{
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	strcpy(address.sun_path, socket_path);
+
+	cflp_server server;
+	server.options = options;
+	server.listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server.listen_fd < 0)
+	{
+		return -1;
+	}
+	unlink(socket_path); // left over by a previous server
+	if (bind(server.listen_fd, (struct sockaddr *) &address, sizeof(address)) != 0 || listen(server.listen_fd, CFLP_SERVER_QUEUE_LEN) != 0)
+	{
+		int error = errno;
+		close(server.listen_fd);
+		errno = error;
+		return -1;
+	}
+	server.stop = 0;
+	pthread_mutex_init(&server.mutex, NULL);
+	pthread_cond_init(&server.not_empty, NULL);
+	pthread_cond_init(&server.not_full, NULL);
+	server.queue_begin = 0;
+	server.queue_len = 0;
+	server.cache = NULL;
+	server.cache_len = 0;
+	server.clock = 0;
+
+	int threads = options->threads > 0 ? options->threads : 1;
+	pthread_t *handles = (pthread_t *) malloc(sizeof(pthread_t) * threads);
+	int started = 0;
+	for (int t = 0; t < threads; t++)
+	{
+		if (pthread_create(&handles[started], NULL, cflp_server_worker, &server) == 0)
+		{
+			started++;
+		}
+	}
+
+	while (started > 0)
+	{
+		int fd = accept(server.listen_fd, NULL, NULL);
+		pthread_mutex_lock(&server.mutex);
+		if (server.stop)
+		{
+			pthread_mutex_unlock(&server.mutex);
+			if (fd >= 0)
+			{
+				close(fd);
+			}
+			break;
+		}
+		if (fd < 0)
+		{
+			pthread_mutex_unlock(&server.mutex);
+			if (errno == EINTR || errno == ECONNABORTED)
+			{
+				continue;
+			}
+			break;
+		}
+		while (server.queue_len == CFLP_SERVER_QUEUE_LEN && !server.stop)
+		{
+			pthread_cond_wait(&server.not_full, &server.mutex);
+		}
+		if (server.stop)
+		{
+			pthread_mutex_unlock(&server.mutex);
+			close(fd);
+			break;
+		}
+		server.queue[(server.queue_begin + server.queue_len) % CFLP_SERVER_QUEUE_LEN] = fd;
+		server.queue_len++;
+		pthread_cond_signal(&server.not_empty);
+		pthread_mutex_unlock(&server.mutex);
+	}
+
+	// the queued connections are still served
+	pthread_mutex_lock(&server.mutex);
+	server.stop = 1;
+	pthread_cond_broadcast(&server.not_empty);
+	pthread_mutex_unlock(&server.mutex);
+	for (int t = 0; t < started; t++)
+	{
+		pthread_join(handles[t], NULL);
+	}
+	free(handles);
+	close(server.listen_fd);
+	unlink(socket_path);
+
+	while (server.cache != NULL)
+	{
+		cflp_server_entry *next = server.cache->next;
+		cflp_server_entry_free(server.cache);
+		server.cache = next;
+	}
+	pthread_cond_destroy(&server.not_full);
+	pthread_cond_destroy(&server.not_empty);
+	pthread_mutex_destroy(&server.mutex);
+	return 0;
+}
@@ -0,0 +1,42 @@
+#include <stddef.h>
+#include "cflp.h"
+
+#ifndef __CFLP_SERVER_HEADER
+#define __CFLP_SERVER_HEADER
+
+// Solver daemon on a Unix domain socket. A client sends any number of requests per connection:
+//
+//   SOLVE <bytes> [text|binary] [time=<ms>] [threads=<n>] [target=<costs>] [abs=<costs>] [rel=<fraction>]
+//   <bytes of the instance, see cflp_instance_reader.h for the binary format>
+//
+// and receives while the search runs
+//
+//   BOUND <lower bound>
+//   INCUMBENT <costs> <facility of customer 0> <facility of customer 1> ...
+//   DONE <optimal|feasible|infeasible|unknown> <objective|-> <lower bound|-> <cached 0|1> <solve ms>
+//
+// or ERROR <message>. SHUTDOWN stops the server after the running requests. The search of a closed
+// connection is cancelled with its next message. Parsed and preprocessed instances are cached by
+// their bytes.
+
+#define CFLP_SERVER_DEFAULT_CACHE_ENTRIES 32
+#define CFLP_SERVER_DEFAULT_MAX_REQUEST_BYTES (1ULL * 1024 * 1024 * 1024)
+
+typedef struct
+{
+	// size of the worker pool, each worker serves one connection at a time
+	int threads;
+	// number of preprocessed instances kept for resubmissions
+	size_t cache_entries;
+	// largest instance a request may send, larger ones are answered with ERROR instance too large
+	size_t max_request_bytes;
+	// defaults of each request, threads, callbacks and cancel flag are replaced
+	bnb_options solve;
+} cflp_server_options;
+
+void cflp_server_options_init(cflp_server_options *options);
+
+// listens on the socket path until SHUTDOWN, returns 0 or -1 with errno if the socket could not be opened
+int cflp_server_run(const char *socket_path, const cflp_server_options *options);
+
+#endif
@@ -0,0 +1,240 @@
+#include "cflp_solver.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct cflp_solver_s
+{
+	cflp_instance *instance;
+	cflp_solver_incumbent_callback callback;
+	void *user_data;
+	int cancel;
+	cflp_solver_status status;
+	cflp_val objective;
+	cflp_val lower_bound;
+	size_t *solution; // num_customers entries, allocated with the solver
+	int has_solution;
+	// incremental re-optimization: the preprocessing is kept between solves and updated by the deltas,
+	// the last solution is the warm start of the next solve
+	bnb_prepared *prepared;
+	int has_previous;
+	cflp_val retained_lower; // lower bound that is still valid after the deltas, CFLP_VAL_INVALID if none
+};
+
+void cflp_solver_on_solution(void* context, cflp_val new_upper_bound, size_t* new_solution, size_t new_solution_length)
+{
+	cflp_solver *solver = (cflp_solver *) context;
+	memcpy(solver->solution, new_solution, sizeof(size_t) * new_solution_length);
+	solver->objective = new_upper_bound;
+	solver->has_solution = 1;
+	if (solver->callback != NULL)
+	{
+		solver->callback(solver->user_data, new_upper_bound, new_solution, new_solution_length);
+	}
+}
+
+void cflp_solver_on_lower_bound(void* context, cflp_val new_lower_bound)
+{
+	((cflp_solver *) context)->lower_bound = new_lower_bound;
+}
+
+cflp_solver *cflp_solver_create(cflp_instance *instance)
+{
+	cflp_solver *solver = (cflp_solver *) malloc(sizeof(cflp_solver));
+	solver->instance = instance;
+	solver->callback = NULL;
+	solver->user_data = NULL;
+	solver->cancel = 0;
+	solver->status = CFLP_SOLVER_UNKNOWN;
+	solver->objective = CFLP_VAL_INVALID;
+	solver->lower_bound = CFLP_VAL_INVALID;
+	solver->solution = (size_t *) malloc(sizeof(size_t) * cflp_instance_get_num_customers(instance));
+	solver->has_solution = 0;
+	solver->prepared = NULL;
+	solver->has_previous = 0;
+	solver->retained_lower = CFLP_VAL_INVALID;
+	return solver;
+}
+
+void cflp_solver_set_incumbent_callback(cflp_solver *solver, cflp_solver_incumbent_callback callback, void *user_data)
+{
+	solver->callback = callback;
+	solver->user_data = user_data;
+}
+
+cflp_solver_status cflp_solver_solve(cflp_solver *solver, const bnb_options *options)
+{
+	bnb_options solve_options;
+	if (options != NULL)
+	{
+		solve_options = *options;
+	}
+	else
+	{
+		bnb_options_init(&solve_options);
+	}
+	solve_options.on_solution = cflp_solver_on_solution;
+	solve_options.on_lower_bound = cflp_solver_on_lower_bound;
+	solve_options.cancel = &solver->cancel;
+	if (solver->has_previous && solve_options.warm_start == NULL)
+	{
+		solve_options.warm_start = solver->solution;
+		solve_options.warm_start_branching = 1;
+	}
+	if (solve_options.lower_bound == CFLP_VAL_INVALID)
+	{
+		solve_options.lower_bound = solver->retained_lower;
+	}
+
+	if (solver->prepared == NULL)
+	{
+		solver->prepared = bnb_prepare_nearest(solver->instance, solve_options.nearest_len, solve_options.stats);
+		if (solver->prepared == NULL)
+		{
+			solver->status = CFLP_SOLVER_UNKNOWN; // out of memory, the next solve tries again
+			return solver->status;
+		}
+	}
+	size_t *warm_start = NULL;
+	if (solve_options.warm_start == solver->solution)
+	{
+		// the search reports its solutions into solver->solution
+		warm_start = (size_t *) malloc(sizeof(size_t) * cflp_instance_get_num_customers(solver->instance));
+		memcpy(warm_start, solver->solution, sizeof(size_t) * cflp_instance_get_num_customers(solver->instance));
+		solve_options.warm_start = warm_start;
+	}
+
+	solver->objective = CFLP_VAL_INVALID;
+	solver->lower_bound = CFLP_VAL_INVALID;
+	solver->has_solution = 0;
+
+	bnb_status result = bnb_run_prepared(solver, solver->prepared, &solve_options);
+	free(warm_start);
+	solver->has_previous = solver->has_solution;
+	solver->retained_lower = solver->lower_bound;
+	if (result == BNB_COMPLETE)
+	{
+		solver->status = solver->has_solution ? CFLP_SOLVER_OPTIMAL : CFLP_SOLVER_INFEASIBLE;
+	}
+	else
+	{
+		solver->status = solver->has_solution ? CFLP_SOLVER_FEASIBLE : CFLP_SOLVER_UNKNOWN;
+	}
+	__atomic_store_n(&solver->cancel, 0, __ATOMIC_RELAXED);
+	return solver->status;
+}
+
+void cflp_solver_cancel(cflp_solver *solver)
+{
+	__atomic_store_n(&solver->cancel, 1, __ATOMIC_RELAXED);
+}
+
+cflp_solver_status cflp_solver_get_status(cflp_solver *solver)
+{
+	return solver->status;
+}
+
+cflp_val cflp_solver_get_objective(cflp_solver *solver)
+{
+	return solver->objective;
+}
+
+cflp_val cflp_solver_get_lower_bound(cflp_solver *solver)
+{
+	return solver->lower_bound;
+}
+
+const size_t *cflp_solver_get_solution(cflp_solver *solver, size_t *solution_len)
+{
+	if (solution_len != NULL)
+	{
+		*solution_len = solver->has_solution ? cflp_instance_get_num_customers(solver->instance) : 0;
+	}
+	return solver->has_solution ? solver->solution : NULL;
+}
+
+// a delta that can make the instance cheaper invalidates the retained lower bound
+void cflp_solver_changed(cflp_solver *solver, int cheaper)
+{
+	if (cheaper)
+	{
+		solver->retained_lower = CFLP_VAL_INVALID;
+	}
+	solver->has_solution = 0;
+	solver->status = CFLP_SOLVER_UNKNOWN;
+	solver->objective = CFLP_VAL_INVALID;
+}
+
+void cflp_solver_set_bandwidth(cflp_solver *solver, size_t customer, cflp_val bandwidth)
+{
+	int cheaper = bandwidth < cflp_instance_bandwidth_of(solver->instance, customer);
+	if (solver->prepared != NULL)
+	{
+		bnb_prepared_set_bandwidth(solver->prepared, customer, bandwidth);
+	}
+	else
+	{
+		cflp_instance_set_bandwidth(solver->instance, customer, bandwidth);
+	}
+	cflp_solver_changed(solver, cheaper);
+}
+
+void cflp_solver_set_opening_costs(cflp_solver *solver, size_t facility, cflp_val opening_costs)
+{
+	int cheaper = opening_costs < cflp_instance_opening_costs_for(solver->instance, facility);
+	if (solver->prepared != NULL)
+	{
+		bnb_prepared_set_opening_costs(solver->prepared, facility, opening_costs);
+	}
+	else
+	{
+		cflp_instance_set_opening_costs(solver->instance, facility, opening_costs);
+	}
+	cflp_solver_changed(solver, cheaper);
+}
+
+void cflp_solver_set_max_customers(cflp_solver *solver, size_t facility, cflp_val max_customers)
+{
+	int cheaper = max_customers > cflp_instance_max_customers_for(solver->instance, facility);
+	if (solver->prepared != NULL)
+	{
+		bnb_prepared_set_max_customers(solver->prepared, facility, max_customers);
+	}
+	else
+	{
+		cflp_instance_set_max_customers(solver->instance, facility, max_customers);
+	}
+	cflp_solver_changed(solver, cheaper);
+}
+
+size_t cflp_solver_add_customer(cflp_solver *solver, cflp_val bandwidth, const cflp_val *distances)
+{
+	size_t customer;
+	if (solver->prepared != NULL)
+	{
+		customer = bnb_prepared_add_customer(solver->prepared, bandwidth, distances);
+	}
+	else
+	{
+		customer = cflp_instance_add_customer(solver->instance, bandwidth, distances);
+	}
+	if (customer == (size_t) -1)
+	{
+		return customer;
+	}
+	solver->solution = (size_t *) realloc(solver->solution, sizeof(size_t) * cflp_instance_get_num_customers(solver->instance));
+	solver->solution[customer] = (size_t) -1; // placed by the repair of the warm start
+	cflp_solver_changed(solver, 0); // every solution gets more expensive or infeasible
+	return customer;
+}
+
+void cflp_solver_free(cflp_solver *solver)
+{
+	if (solver->prepared != NULL)
+	{
+		bnb_prepared_free(solver->prepared);
+		solver->prepared = NULL;
+	}
+	free(solver->solution);
+	solver->solution = NULL;
+	free(solver);
+}
@@ -0,0 +1,61 @@
+#include "cflp.h"
+
+#ifndef __CFLP_SOLVER_HEADER
+#define __CFLP_SOLVER_HEADER
+
+// Embeddable solver (libccflp). A solver handle belongs to one thread at a time, except for
+// cflp_solver_cancel(). Different handles may solve concurrently, also on the same instance,
+// which is only read.
+
+typedef enum
+{
+	CFLP_SOLVER_OPTIMAL, // proven optimal (within the tolerance of the options)
+	CFLP_SOLVER_FEASIBLE, // a solution was found but the search was stopped or returned at the target
+	CFLP_SOLVER_INFEASIBLE, // proven that there is no solution (with costs <= target in decision mode)
+	CFLP_SOLVER_UNKNOWN // stopped before any solution was found
+} cflp_solver_status;
+
+typedef struct cflp_solver_s cflp_solver;
+
+// called in the solving thread for each improved solution, the solution is only valid during the call
+typedef void (*cflp_solver_incumbent_callback)(void *user_data, cflp_val costs, const size_t *solution, size_t solution_len);
+
+// the instance is not copied and has to outlive the solver, the deltas below change it
+cflp_solver *cflp_solver_create(cflp_instance *instance);
+
+void cflp_solver_set_incumbent_callback(cflp_solver *solver, cflp_solver_incumbent_callback callback, void *user_data);
+
+// solves the instance, options may be NULL for the defaults (bnb_options_init()), their callbacks
+// and cancel flag are replaced by the solver. The preprocessing is done once per solver. After the
+// first solve the last solution is the warm start (unless options has one) and its lower bound is
+// kept as long as the deltas can not make the instance cheaper.
+cflp_solver_status cflp_solver_solve(cflp_solver *solver, const bnb_options *options);
+
+// may be called from any thread, the running (or next) solve returns soon
+void cflp_solver_cancel(cflp_solver *solver);
+
+cflp_solver_status cflp_solver_get_status(cflp_solver *solver);
+
+// costs of the best solution, CFLP_VAL_INVALID if there is none
+cflp_val cflp_solver_get_objective(cflp_solver *solver);
+
+cflp_val cflp_solver_get_lower_bound(cflp_solver *solver);
+
+// facility index per customer of the best solution, NULL if there is none
+const size_t *cflp_solver_get_solution(cflp_solver *solver, size_t *solution_len);
+
+// deltas for incremental re-optimization, they update the instance and only the affected parts of
+// the preprocessing; not while the solver runs
+
+void cflp_solver_set_bandwidth(cflp_solver *solver, size_t customer, cflp_val bandwidth);
+
+void cflp_solver_set_opening_costs(cflp_solver *solver, size_t facility, cflp_val opening_costs);
+
+void cflp_solver_set_max_customers(cflp_solver *solver, size_t facility, cflp_val max_customers);
+
+// appends a customer with its distance to each facility, returns its index
+size_t cflp_solver_add_customer(cflp_solver *solver, cflp_val bandwidth, const cflp_val *distances);
+
+void cflp_solver_free(cflp_solver *solver);
+
+#endif
@@ -0,0 +1,263 @@
+#include "cflp_stats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char *cflp_stats_phase_names[CFLP_PHASE_COUNT] = { "load", "preprocess", "heuristic", "search" };
+
+long long cflp_stats_now_us()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+cflp_stats *cflp_stats_create()
+{
+	cflp_stats *stats = (cflp_stats *) malloc(sizeof(cflp_stats));
+	memset(stats, 0, sizeof(cflp_stats));
+	stats->start_us = cflp_stats_now_us();
+	for (int i = 0; i < CFLP_PHASE_COUNT; i++)
+	{
+		stats->phase_begin_us[i] = -1;
+		stats->phase_end_us[i] = -1;
+	}
+	return stats;
+}
+
+cflp_stats *cflp_stats_create_child(cflp_stats *parent)
+{
+	cflp_stats *stats = cflp_stats_create();
+	stats->start_us = parent->start_us;
+	stats->parent = parent;
+	cflp_stats_set_depth(stats, parent->depth_len);
+	return stats;
+}
+
+void cflp_stats_set_depth(cflp_stats *stats, size_t max_depth)
+{
+	if (stats->depth_len >= max_depth)
+	{
+		return;
+	}
+	stats->depth_nodes = (unsigned long long *) realloc(stats->depth_nodes, sizeof(unsigned long long) * max_depth);
+	memset(stats->depth_nodes + stats->depth_len, 0, sizeof(unsigned long long) * (max_depth - stats->depth_len));
+	stats->depth_len = max_depth;
+}
+
+void cflp_stats_phase_begin(cflp_stats *stats, cflp_phase phase)
+{
+	stats->phase_begin_us[phase] = cflp_stats_now_us() - stats->start_us;
+	stats->phase_end_us[phase] = -1;
+}
+
+void cflp_stats_phase_end(cflp_stats *stats, cflp_phase phase)
+{
+	stats->phase_end_us[phase] = cflp_stats_now_us() - stats->start_us;
+}
+
+long long cflp_stats_phase_us(cflp_stats *stats, cflp_phase phase)
+{
+	if (stats->phase_begin_us[phase] < 0)
+	{
+		return 0;
+	}
+	if (stats->phase_end_us[phase] < 0) // still running or cancelled
+	{
+		return cflp_stats_now_us() - stats->start_us - stats->phase_begin_us[phase];
+	}
+	return stats->phase_end_us[phase] - stats->phase_begin_us[phase];
+}
+
+void cflp_stats_incumbent(cflp_stats *stats, cflp_val costs)
+{
+	stats->incumbents++;
+	if (stats->events_len < CFLP_STATS_MAX_EVENTS)
+	{
+		stats->events[stats->events_len].time_us = cflp_stats_now_us() - stats->start_us;
+		stats->events[stats->events_len].costs = costs;
+		stats->events_len++;
+	}
+}
+
+void cflp_stats_publish(cflp_stats *stats, size_t depth)
+{
+	if (stats->parent != NULL)
+	{
+		__atomic_fetch_add(&stats->parent->progress_nodes, stats->nodes - stats->published_nodes, __ATOMIC_RELAXED);
+		__atomic_store_n(&stats->parent->progress_depth, depth, __ATOMIC_RELAXED);
+	}
+	else
+	{
+		__atomic_store_n(&stats->progress_nodes, stats->nodes, __ATOMIC_RELAXED);
+		__atomic_store_n(&stats->progress_depth, depth, __ATOMIC_RELAXED);
+	}
+	stats->published_nodes = stats->nodes;
+}
+
+unsigned long long cflp_stats_progress_nodes(cflp_stats *stats)
+{
+	return __atomic_load_n(&stats->progress_nodes, __ATOMIC_RELAXED);
+}
+
+size_t cflp_stats_progress_depth(cflp_stats *stats)
+{
+	return __atomic_load_n(&stats->progress_depth, __ATOMIC_RELAXED);
+}
+
+int cflp_stats_compare_events(const void *a, const void *b)
+{
+	long long x = ((const cflp_stats_event *) a)->time_us;
+	long long y = ((const cflp_stats_event *) b)->time_us;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+void cflp_stats_merge(cflp_stats *stats, cflp_stats *other)
+{
+	stats->nodes += other->nodes;
+	stats->pruned_bound += other->pruned_bound;
+	stats->pruned_capacity += other->pruned_capacity;
+	stats->pruned_theo += other->pruned_theo;
+	stats->incumbents += other->incumbents;
+	stats->table_hits += other->table_hits;
+	stats->table_misses += other->table_misses;
+	stats->table_replaced += other->table_replaced;
+	stats->restarts += other->restarts;
+	stats->epochs += other->epochs;
+	stats->epoch_wait_us += other->epoch_wait_us;
+
+	cflp_stats_set_depth(stats, other->depth_len);
+	for (size_t i = 0; i < other->depth_len; i++)
+	{
+		stats->depth_nodes[i] += other->depth_nodes[i];
+	}
+
+	long long offset = other->start_us - stats->start_us;
+	for (size_t i = 0; i < other->events_len && stats->events_len < CFLP_STATS_MAX_EVENTS; i++)
+	{
+		stats->events[stats->events_len] = other->events[i];
+		stats->events[stats->events_len].time_us += offset;
+		stats->events_len++;
+	}
+	qsort(stats->events, stats->events_len, sizeof(cflp_stats_event), cflp_stats_compare_events);
+}
+
+size_t cflp_stats_max_depth(cflp_stats *stats)
+{
+	size_t max_depth = 0;
+	for (size_t i = 0; i < stats->depth_len; i++)
+	{
+		if (stats->depth_nodes[i] != 0)
+		{
+			max_depth = i + 1;
+		}
+	}
+	return max_depth;
+}
+
+void cflp_stats_print_text(cflp_stats *stats, FILE *file)
+{
+	long long search_us = cflp_stats_phase_us(stats, CFLP_PHASE_SEARCH);
+	fprintf(file, "STATS nodes: %llu (%.0f/s)\n", stats->nodes, search_us > 0 ? stats->nodes * 1e6 / search_us : 0.0);
+	fprintf(file, "STATS pruned: bound %llu, capacity %llu, theo %llu\n", stats->pruned_bound, stats->pruned_capacity, stats->pruned_theo);
+	fprintf(file, "STATS incumbents: %llu", stats->incumbents);
+	if (stats->events_len > 0)
+	{
+		fprintf(file, ", first after %.3fms", stats->events[0].time_us / 1000.0);
+		fprintf(file, ", last after %.3fms", stats->events[stats->events_len - 1].time_us / 1000.0);
+	}
+	fprintf(file, "\n");
+	if (stats->table_hits + stats->table_misses > 0)
+	{
+		fprintf(file, "STATS table: hits %llu (%.1f%%), misses %llu, replaced %llu\n", stats->table_hits,
+				stats->table_hits * 100.0 / (stats->table_hits + stats->table_misses), stats->table_misses, stats->table_replaced);
+	}
+	if (stats->restarts > 0)
+	{
+		fprintf(file, "STATS restarts: %llu\n", stats->restarts);
+	}
+	if (stats->epochs > 0)
+	{
+		fprintf(file, "STATS epochs: %llu, waited %.3fms\n", stats->epochs, stats->epoch_wait_us / 1000.0);
+	}
+	fprintf(file, "STATS time:");
+	for (int i = 0; i < CFLP_PHASE_COUNT; i++)
+	{
+		fprintf(file, " %s %.3fms", cflp_stats_phase_names[i], cflp_stats_phase_us(stats, i) / 1000.0);
+	}
+	fprintf(file, "\n");
+
+	// depth profile in at most 10 buckets
+	size_t max_depth = cflp_stats_max_depth(stats);
+	size_t bucket = (max_depth + 9) / 10;
+	for (size_t begin = 0; begin < max_depth; begin += bucket)
+	{
+		unsigned long long nodes = 0;
+		for (size_t i = begin; i < begin + bucket && i < max_depth; i++)
+		{
+			nodes += stats->depth_nodes[i];
+		}
+		fprintf(file, "STATS depth %zu-%zu: %llu\n", begin, begin + bucket - 1 < max_depth ? begin + bucket - 1 : max_depth - 1, nodes);
+	}
+}
+
+void cflp_stats_print_json(cflp_stats *stats, FILE *file)
+{
+	fprintf(file, "{\"nodes\":%llu,\"pruned_bound\":%llu,\"pruned_capacity\":%llu,\"pruned_theo\":%llu,\"incumbents\":%llu",
+			stats->nodes, stats->pruned_bound, stats->pruned_capacity, stats->pruned_theo, stats->incumbents);
+	fprintf(file, ",\"table_hits\":%llu,\"table_misses\":%llu,\"table_replaced\":%llu,\"restarts\":%llu",
+			stats->table_hits, stats->table_misses, stats->table_replaced, stats->restarts);
+	fprintf(file, ",\"epochs\":%llu,\"epoch_wait_us\":%lld", stats->epochs, stats->epoch_wait_us);
+	fprintf(file, ",\"phases_us\":{");
+	for (int i = 0; i < CFLP_PHASE_COUNT; i++)
+	{
+		fprintf(file, "%s\"%s\":%lld", i > 0 ? "," : "", cflp_stats_phase_names[i], cflp_stats_phase_us(stats, i));
+	}
+	fprintf(file, "},\"incumbent_events\":[");
+	for (size_t i = 0; i < stats->events_len; i++)
+	{
+		fprintf(file, "%s{\"time_us\":%lld,\"costs\":%" CFLP_VAL_FMT "}", i > 0 ? "," : "", stats->events[i].time_us, stats->events[i].costs);
+	}
+	fprintf(file, "],\"depth_nodes\":[");
+	size_t max_depth = cflp_stats_max_depth(stats);
+	for (size_t i = 0; i < max_depth; i++)
+	{
+		fprintf(file, "%s%llu", i > 0 ? "," : "", stats->depth_nodes[i]);
+	}
+	fprintf(file, "]}\n");
+}
+
+void cflp_stats_print_trace(cflp_stats *stats, FILE *file)
+{
+	fprintf(file, "{\"traceEvents\":[");
+	int first = 1;
+	for (int i = 0; i < CFLP_PHASE_COUNT; i++)
+	{
+		if (stats->phase_begin_us[i] < 0)
+		{
+			continue;
+		}
+		fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"phase\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%lld,\"dur\":%lld}",
+				first ? "" : ",", cflp_stats_phase_names[i], stats->phase_begin_us[i], cflp_stats_phase_us(stats, i));
+		first = 0;
+	}
+	for (size_t i = 0; i < stats->events_len; i++)
+	{
+		fprintf(file, "%s\n{\"name\":\"incumbent\",\"cat\":\"search\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":1,\"ts\":%lld,\"args\":{\"costs\":%" CFLP_VAL_FMT "}}",
+				first ? "" : ",", stats->events[i].time_us, stats->events[i].costs);
+		fprintf(file, ",\n{\"name\":\"costs\",\"ph\":\"C\",\"pid\":1,\"ts\":%lld,\"args\":{\"incumbent\":%" CFLP_VAL_FMT "}}",
+				stats->events[i].time_us, stats->events[i].costs);
+		first = 0;
+	}
+	fprintf(file, "\n]}\n");
+}
+
+void cflp_stats_free(cflp_stats *stats)
+{
+	if (stats->depth_nodes != NULL)
+	{
+		free(stats->depth_nodes);
+		stats->depth_nodes = NULL;
+	}
+	free(stats);
+}
@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include "cflp_instance.h"
+
+#ifndef __CFLP_STATS_HEADER
+#define __CFLP_STATS_HEADER
+
+// maximum number of recorded incumbent improvements, further improvements are only counted
+#define CFLP_STATS_MAX_EVENTS 4096
+// the search publishes its progress every 2^CFLP_STATS_PUBLISH_SHIFT nodes
+#define CFLP_STATS_PUBLISH_SHIFT 14
+
+typedef enum
+{
+	CFLP_PHASE_LOAD,
+	CFLP_PHASE_PREPROCESS,
+	CFLP_PHASE_HEURISTIC,
+	CFLP_PHASE_SEARCH,
+	CFLP_PHASE_COUNT
+} cflp_phase;
+
+typedef struct
+{
+	long long time_us; // since cflp_stats_create()
+	cflp_val costs;
+} cflp_stats_event;
+
+struct cflp_stats_s
+{
+	unsigned long long nodes;
+	unsigned long long pruned_bound; // L < U bounding failed
+	unsigned long long pruned_capacity; // canAddUser() failed
+	unsigned long long pruned_theo; // Theo's improvement skipped the remaining facilities
+	unsigned long long incumbents;
+	unsigned long long table_hits; // the transposition table pruned the node
+	unsigned long long table_misses; // state not stored or only with higher costs
+	unsigned long long table_replaced; // a store evicted another state
+	unsigned long long restarts; // runs of a search with restarts after the first one
+	unsigned long long epochs; // of a deterministic parallel search
+	long long epoch_wait_us; // the threads waited for the other ones at the ends of the epochs
+
+	unsigned long long* depth_nodes; // nodes per depth
+	size_t depth_len;
+
+	long long start_us;
+	long long phase_begin_us[CFLP_PHASE_COUNT];
+	long long phase_end_us[CFLP_PHASE_COUNT];
+
+	cflp_stats_event events[CFLP_STATS_MAX_EVENTS];
+	size_t events_len;
+
+	// snapshot for progress reports of other threads, only accessed atomically
+	unsigned long long progress_nodes;
+	size_t progress_depth;
+
+	// statistics of a search thread publish their progress to the parent
+	struct cflp_stats_s* parent;
+	unsigned long long published_nodes;
+};
+
+typedef struct cflp_stats_s cflp_stats;
+
+#ifdef CFLP_STATS
+#define CFLP_STATS_ENABLED 1
+#define CFLP_STATS_COUNT(stats, counter) ((stats)->counter++)
+#define CFLP_STATS_NODE(stats, depth) \
+	do { \
+		(stats)->nodes++; \
+		(stats)->depth_nodes[depth]++; \
+		if (((stats)->nodes & ((1ULL << CFLP_STATS_PUBLISH_SHIFT) - 1)) == 0) \
+			cflp_stats_publish(stats, depth); \
+	} while (0)
+#define CFLP_STATS_PHASE_BEGIN(stats, phase) cflp_stats_phase_begin(stats, phase)
+#define CFLP_STATS_PHASE_END(stats, phase) cflp_stats_phase_end(stats, phase)
+#define CFLP_STATS_INCUMBENT(stats, costs) cflp_stats_incumbent(stats, costs)
+#else
+#define CFLP_STATS_ENABLED 0
+#define CFLP_STATS_COUNT(stats, counter) ((void) 0)
+#define CFLP_STATS_NODE(stats, depth) ((void) 0)
+#define CFLP_STATS_PHASE_BEGIN(stats, phase) ((void) 0)
+#define CFLP_STATS_PHASE_END(stats, phase) ((void) 0)
+#define CFLP_STATS_INCUMBENT(stats, costs) ((void) 0)
+#endif
+
+long long cflp_stats_now_us();
+
+cflp_stats *cflp_stats_create();
+
+// statistics of a search thread, merge them into the parent with cflp_stats_merge()
+cflp_stats *cflp_stats_create_child(cflp_stats *parent);
+
+// allocates the depth profile for searches with up to max_depth levels
+void cflp_stats_set_depth(cflp_stats *stats, size_t max_depth);
+
+void cflp_stats_phase_begin(cflp_stats *stats, cflp_phase phase);
+
+void cflp_stats_phase_end(cflp_stats *stats, cflp_phase phase);
+
+long long cflp_stats_phase_us(cflp_stats *stats, cflp_phase phase);
+
+void cflp_stats_incumbent(cflp_stats *stats, cflp_val costs);
+
+void cflp_stats_publish(cflp_stats *stats, size_t depth);
+
+unsigned long long cflp_stats_progress_nodes(cflp_stats *stats);
+
+size_t cflp_stats_progress_depth(cflp_stats *stats);
+
+// adds the counters of another thread
+void cflp_stats_merge(cflp_stats *stats, cflp_stats *other);
+
+void cflp_stats_print_text(cflp_stats *stats, FILE *file);
+
+void cflp_stats_print_json(cflp_stats *stats, FILE *file);
+
+// writes the phases and incumbent improvements in the Chrome trace event format
+void cflp_stats_print_trace(cflp_stats *stats, FILE *file);
+
+void cflp_stats_free(cflp_stats *stats);
+
+#endif
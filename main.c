@@ -2,6 +2,9 @@
 #include "cflp_instance_reader.h"
 #include "block_buffer.h"
 #include "cflp.h"
+#include "cflp_batch.h"
+#include "cflp_evaluator.h"
+#include "cflp_server.h"
 #include <stdlib.h>
 #include <string.h>
 #include <sys/timeb.h>
@@ -30,13 +33,17 @@ typedef struct
 {
 	cflp_instance *instance;
 	pthread_mutex_t mutex;
+	const bnb_options *options;
 	cflp_val upper_bound;
+	cflp_val lower_bound;
 	size_t* solution;
 	size_t solution_length;
+	int started;
+	int cancel;
 	pthread_cond_t cond;
 } bnb_args;
 
-void set_solution(bnb_args* args, int new_upper_bound, size_t* new_solution, int new_solution_length)
+void set_solution(bnb_args* args, cflp_val new_upper_bound, size_t* new_solution, int new_solution_length)
 {
 	int res = pthread_mutex_lock(&args->mutex);
 	if (res == 0)
@@ -58,54 +65,121 @@ void bnb_set_solution(void* context, cflp_val new_upper_bound, size_t* new_solut
 	set_solution((bnb_args*)context, new_upper_bound, new_solution, new_solution_length);
 }
 
+void bnb_set_lower_bound(void* context, cflp_val new_lower_bound)
+{
+	bnb_args* args = (bnb_args*)context;
+	pthread_mutex_lock(&args->mutex);
+	args->lower_bound = new_lower_bound;
+	pthread_mutex_unlock(&args->mutex);
+}
+
+const char* solution_check_message(cflp_solution_check check)
+{
+	switch (check)
+	{
+	case CFLP_SOLUTION_LENGTH:
+		return "Ihre Loesung hat zu wenige/viele Kunden!";
+	case CFLP_SOLUTION_FACILITY:
+		return "Ungueltiger Facility Index!";
+	case CFLP_SOLUTION_BANDWIDTH:
+		return "Eine Facility verbraucht zu viel Bandbreite!";
+	case CFLP_SOLUTION_CUSTOMERS:
+		return "Eine Facility hat zu viele Kunden!";
+	default:
+		return "";
+	}
+}
+
 void* run_thread(void* param)
 {
-	pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
-	pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, NULL);
 	bnb_args* args = (bnb_args*)param;
 	pthread_mutex_lock(&args->mutex);
+	args->started = 1;
 	pthread_cond_signal(&args->cond);
 	pthread_mutex_unlock(&args->mutex);
 	cflp_instance *instance = args->instance;
-	bnb_run(param, instance);
+	bnb_options options = *args->options;
+	options.on_solution = bnb_set_solution;
+	options.on_lower_bound = bnb_set_lower_bound;
+	options.cancel = &args->cancel;
+	bnb_run(param, instance, &options);
 	return NULL;
 }
 
-void run(cflp_instance *instance, int dontStop, int test, int debug, const char *choppedFileName)
+void print_progress(bnb_args* args, millisec elapsed)
+{
+	pthread_mutex_lock(&args->mutex);
+	cflp_val upper_bound = args->upper_bound;
+	cflp_val lower_bound = args->lower_bound;
+	pthread_mutex_unlock(&args->mutex);
+
+	fprintf(stderr, "PROGRESS %.1fs", elapsed / 1000.0);
+	cflp_stats *stats = args->options->stats;
+	if (stats != NULL)
+	{
+		unsigned long long nodes = cflp_stats_progress_nodes(stats);
+		fprintf(stderr, " nodes: %llu (%.0f/s) depth: %zu", nodes, elapsed > 0 ? nodes * 1000.0 / elapsed : 0.0, cflp_stats_progress_depth(stats));
+	}
+	fprintf(stderr, " incumbent: %" CFLP_VAL_FMT " bound: %" CFLP_VAL_FMT "\n", upper_bound, lower_bound);
+}
+
+void run(cflp_instance *instance, const bnb_options *options, int progress, int dontStop, int test, int debug, const char *choppedFileName)
 {
 	cflp_instance *original = cflp_instance_copy(instance);
 	
 	millisec start = currentTimeMillis();
 	millisec end = currentTimeMillis();
 	millisec offs = end - start;
-	millisec timeout = 30000; // 30 secounds
+	millisec timeout = options->time_limit_ms > 0 ? options->time_limit_ms : 30000; // 30 secounds
 
 	pthread_t thread;
 	bnb_args args;
 	args.instance = instance;
+	args.options = options;
 	pthread_mutex_init(&args.mutex, NULL);
 	pthread_cond_init(&args.cond, NULL);
 	args.solution = NULL;
 	args.solution_length = 0;
 	args.upper_bound = CFLP_VAL_INVALID;
+	args.lower_bound = CFLP_VAL_INVALID;
+	args.started = 0;
+	args.cancel = 0;
 
-	
 
 	pthread_create(&thread, NULL, run_thread, &args);
 	pthread_mutex_lock(&args.mutex);
-	pthread_cond_wait(&args.cond, &args.mutex);
+	while (!args.started)
+	{
+		pthread_cond_wait(&args.cond, &args.mutex);
+	}
 	pthread_mutex_unlock(&args.mutex);
 
-	struct timeb tmb;
-	ftime(&tmb);
-	struct timespec abstime;
-	abstime.tv_nsec = ((timeout % 1000) + tmb.millitm) * 1000000;
-	abstime.tv_sec = tmb.time + timeout / 1000;
-	pthread_timedjoin_np(thread, NULL, &abstime);
-	pthread_mutex_lock(&args.mutex);
-	pthread_cancel(thread);
-	pthread_mutex_unlock(&args.mutex);
-	pthread_join(thread, NULL);
+	// wait in slices of one second if the progress is printed
+	millisec deadline = start + timeout;
+	int joined = 0;
+	while (!joined)
+	{
+		millisec now = currentTimeMillis();
+		if (now >= deadline)
+		{
+			break;
+		}
+		millisec wakeup = progress && deadline - now > 1000 ? now + 1000 : deadline;
+		struct timespec abstime;
+		abstime.tv_sec = wakeup / 1000;
+		abstime.tv_nsec = (wakeup % 1000) * 1000000;
+		joined = pthread_timedjoin_np(thread, NULL, &abstime) == 0;
+		if (!joined && progress)
+		{
+			print_progress(&args, currentTimeMillis() - start);
+		}
+	}
+	if (!joined)
+	{
+		// the search checks the flag every few thousand nodes
+		__atomic_store_n(&args.cancel, 1, __ATOMIC_RELAXED);
+		pthread_join(thread, NULL);
+	}
 	pthread_mutex_destroy(&args.mutex);
 	pthread_cond_destroy(&args.cond);
 
@@ -113,11 +187,14 @@ void run(cflp_instance *instance, int dontStop, int test, int debug, const char
 
 	millisec sum123 = end - start - offs;
 
-	int* used_bandwidths = NULL;
-	int* connected_customers = NULL;
 	block_buffer *msg = block_buffer_create();
 	do
 	{
+		if (args.solution == NULL && options->target != CFLP_VAL_INVALID && args.lower_bound > options->target)
+		{
+			bailOut("Es gibt keine Loesung unter dem Schwellwert!");
+			break;
+		}
 		if (args.solution == NULL)
 		{
 			bailOut("Keine gueltige Loesung!");
@@ -128,53 +205,23 @@ void run(cflp_instance *instance, int dontStop, int test, int debug, const char
 		size_t* solution = args.solution;
 		size_t solution_length = args.solution_length;
 
-		if (solution_length != original->num_customers)
+		if (solution_length != cflp_instance_get_num_customers(original))
 		{
-			bailOut("Ihre Loesung hat zu wenige/viele Kunden!");
+			bailOut(solution_check_message(CFLP_SOLUTION_LENGTH));
 			break;
 		}
-
-		used_bandwidths = (int*)malloc(sizeof(int)* cflp_instance_get_num_facilities(original));
-		memset(used_bandwidths, 0, sizeof(int)* cflp_instance_get_num_facilities(original));
-		connected_customers = (int*)malloc(sizeof(int)* cflp_instance_get_num_facilities(original));
-		memset(connected_customers, 0, sizeof(int)* cflp_instance_get_num_facilities(original));
-
-		size_t fIdx;
-		int error = 0;
-		for (size_t i = 0; i < original->num_customers; ++i) {
-			fIdx = solution[i];
-			if (fIdx < 0 || fIdx >= cflp_instance_get_num_facilities(original))
-			{
-				bailOut("Ungueltiger Facility Index!");
-				error = 1;
-				break;
-			}
-
-			used_bandwidths[fIdx] += cflp_instance_bandwidth_of(original, i);
-			if (used_bandwidths[fIdx] > original->max_bandwith)
-			{
-				bailOut("Eine Facility verbraucht zu viel Bandbreite!");
-				error = 1;
-				break;
-			}
-				
-
-			connected_customers[fIdx] += 1;
-			if (connected_customers[fIdx] > cflp_instance_max_customers_for(original, fIdx))
-			{
-				bailOut("Eine Facility hat zu viele Kunden!");
-				error = 1;
-				break;
-			}
-		}
-		if (error)
+		cflp_solution_check check;
+		cflp_val objectiveValue;
+		cflp_evaluator *evaluator = cflp_evaluator_create(original);
+		cflp_evaluator_evaluate(evaluator, solution, 1, &check, &objectiveValue);
+		cflp_evaluator_free(evaluator);
+		if (check != CFLP_SOLUTION_VALID)
 		{
+			bailOut(solution_check_message(check));
 			break;
 		}
 
-		cflp_val objectiveValue = cflp_instance_calc_objective_value(original, solution, solution_length);
-
-		if (abs(objectiveValue - upper_bound) > 0) {
+		if (llabs(objectiveValue - upper_bound) > 0) {
 			bailOut("Die obere Schranke muss immer gleich der aktuell besten Loesung sein!");
 			break;
 		}
@@ -194,7 +241,7 @@ void run(cflp_instance *instance, int dontStop, int test, int debug, const char
 
 		if (upper_bound > original->threshold)
 		{
-			printf("\nERR zu schlechte Loesung: Ihr Ergebnis %d liegt ueber dem Schwellwert (%d)\n", upper_bound, original->threshold);
+			printf("\nERR zu schlechte Loesung: Ihr Ergebnis %" CFLP_VAL_FMT " liegt ueber dem Schwellwert (%" CFLP_VAL_FMT ")\n", upper_bound, original->threshold);
 			break;
 		}
 		
@@ -203,6 +250,15 @@ void run(cflp_instance *instance, int dontStop, int test, int debug, const char
 		block_buffer_append_string(msg, ". Ihr Ergebnis ist OK mit \n");
 		block_buffer_append_int(msg, upper_bound);
 
+		if (args.lower_bound != CFLP_VAL_INVALID)
+		{
+			char gap[32];
+			snprintf(gap, sizeof(gap), "%.3f%%", upper_bound > 0 ? 100.0 * (upper_bound - args.lower_bound) / upper_bound : 0.0);
+			block_buffer_append_string(msg, ", untere Schranke: ");
+			block_buffer_append_int(msg, args.lower_bound);
+			block_buffer_append_string(msg, ", Luecke: ");
+			block_buffer_append_string(msg, gap);
+		}
 		if (test)
 		{
 			if (sum > 1000)
@@ -224,21 +280,36 @@ void run(cflp_instance *instance, int dontStop, int test, int debug, const char
 	
 	block_buffer_free(msg);
 
+	if (options->pool != NULL)
+	{
+		// one line per alternative: rank, costs and the facility per customer
+		cflp_evaluator *evaluator = cflp_evaluator_create(original);
+		for (size_t rank = 0; rank < cflp_pool_size(options->pool); rank++)
+		{
+			const size_t *alternative = cflp_pool_solution(options->pool, rank);
+			cflp_solution_check check;
+			cflp_val objectiveValue;
+			cflp_evaluator_evaluate(evaluator, alternative, 1, &check, &objectiveValue);
+			printf("Alternative %zu: %" CFLP_VAL_FMT, rank + 1, objectiveValue);
+			if (check != CFLP_SOLUTION_VALID || objectiveValue != cflp_pool_costs(options->pool, rank))
+			{
+				printf(" ERR %s", check != CFLP_SOLUTION_VALID ? solution_check_message(check) : "Kosten stimmen nicht!");
+			}
+			printf(" |");
+			for (size_t i = 0; i < cflp_pool_num_customers(options->pool); i++)
+			{
+				printf(" %zu", alternative[i]);
+			}
+			printf("\n");
+		}
+		cflp_evaluator_free(evaluator);
+	}
+
 	if (args.solution != NULL)
 	{
 		free(args.solution);
 		args.solution = NULL;
 	}
-	if (used_bandwidths != NULL)
-	{
-		free(used_bandwidths);
-		used_bandwidths = NULL;
-	}
-	if (connected_customers != NULL)
-	{
-		free(connected_customers);
-		connected_customers = NULL;
-	}
 
 	cflp_instance_free(original);
 }
@@ -250,6 +321,22 @@ int main(int argv, char** argc)
 	int dontStop = 1;
 	int test = 1;
 	int debug = 0;
+	bnb_options options;
+	bnb_options_init(&options);
+	int decision = 0;
+	int progress = 0;
+	int print_stats = 0;
+	const char* stats_json = NULL;
+	const char* trace = NULL;
+	int batch = 0;
+	const char* serve = NULL;
+	const char* warm_start = NULL;
+	const char* resume = NULL;
+	const char* mapped = NULL;
+	size_t pool_size = 0;
+	size_t pool_distance = 1;
+	const char** paths = (const char**)malloc(sizeof(const char*) * argv);
+	size_t num_paths = 0;
 
 	for (int i = 1; i < argv; i++)
 	{
@@ -265,16 +352,276 @@ int main(int argv, char** argc)
 		{
 			debug = test = 1;
 		}
+		else if (strcmp(argc[i], "-T") == 0)
+		{
+			decision = 1;
+		}
+		else if (strcmp(argc[i], "--progress") == 0)
+		{
+			progress = 1;
+		}
+		else if (strcmp(argc[i], "--stats") == 0)
+		{
+			print_stats = 1;
+		}
+		else if (strcmp(argc[i], "--stats-json") == 0 && i + 1 < argv)
+		{
+			stats_json = argc[++i];
+		}
+		else if (strcmp(argc[i], "--trace") == 0 && i + 1 < argv)
+		{
+			trace = argc[++i];
+		}
+		else if (strcmp(argc[i], "-a") == 0 && i + 1 < argv)
+		{
+			options.tolerance_abs = atoll(argc[++i]);
+		}
+		else if (strcmp(argc[i], "-r") == 0 && i + 1 < argv)
+		{
+			options.tolerance_rel = atof(argc[++i]);
+		}
+		else if (strcmp(argc[i], "-j") == 0 && i + 1 < argv)
+		{
+			options.threads = atoi(argc[++i]);
+		}
+		else if (strcmp(argc[i], "--time-limit") == 0 && i + 1 < argv)
+		{
+			options.time_limit_ms = atoll(argc[++i]);
+		}
+		else if (strcmp(argc[i], "-w") == 0 && i + 1 < argv)
+		{
+			warm_start = argc[++i];
+		}
+		else if (strcmp(argc[i], "--warm-branching") == 0)
+		{
+			options.warm_start_branching = 1;
+		}
+		else if (strcmp(argc[i], "--nearest") == 0 && i + 1 < argv)
+		{
+			options.nearest_len = (size_t) atoll(argc[++i]);
+		}
+		else if (strcmp(argc[i], "--pages") == 0 && i + 1 < argv)
+		{
+			// small, transparent (default) or explicit huge pages for the large arrays
+			const char* pages = argc[++i];
+			cflp_memory_set_pages(strcmp(pages, "small") == 0 ? CFLP_PAGES_SMALL
+				: (strcmp(pages, "explicit") == 0 ? CFLP_PAGES_EXPLICIT : CFLP_PAGES_TRANSPARENT));
+		}
+		else if (strcmp(argc[i], "--placement") == 0 && i + 1 < argv)
+		{
+			// local (default), interleave or replicate on NUMA machines with -j
+			const char* placement = argc[++i];
+			options.placement = strcmp(placement, "interleave") == 0 ? CFLP_PLACEMENT_INTERLEAVE
+				: (strcmp(placement, "replicate") == 0 ? CFLP_PLACEMENT_REPLICATE : CFLP_PLACEMENT_LOCAL);
+		}
+		else if (strcmp(argc[i], "--cache") == 0 && i + 1 < argv)
+		{
+			// preprocessing cache file, rebuilt if it belongs to another instance
+			options.cache_path = argc[++i];
+		}
+		else if (strcmp(argc[i], "--mapped") == 0 && i + 1 < argv)
+		{
+			// distances mapped from a binary instance file, a text instance is converted into this file first
+			mapped = argc[++i];
+		}
+		else if (strcmp(argc[i], "--lds") == 0)
+		{
+			options.strategy = BNB_STRATEGY_DISCREPANCY;
+		}
+		else if (strcmp(argc[i], "--beam") == 0 && i + 1 < argv)
+		{
+			options.strategy = BNB_STRATEGY_BEAM;
+			options.beam_width = (size_t) atoll(argc[++i]);
+		}
+		else if (strcmp(argc[i], "--restarts") == 0 && i + 1 < argv)
+		{
+			options.restart_nodes = (unsigned long long) atoll(argc[++i]);
+		}
+		else if (strcmp(argc[i], "--seed") == 0 && i + 1 < argv)
+		{
+			options.restart_seed = (unsigned long long) atoll(argc[++i]);
+		}
+		else if (strcmp(argc[i], "--pool") == 0 && i + 1 < argv)
+		{
+			// lists the cheapest solutions that differ in at least --pool-distance customers
+			pool_size = (size_t) atoll(argc[++i]);
+		}
+		else if (strcmp(argc[i], "--pool-distance") == 0 && i + 1 < argv)
+		{
+			pool_distance = (size_t) atoll(argc[++i]);
+		}
+		else if (strcmp(argc[i], "--deterministic") == 0)
+		{
+			options.deterministic = 1;
+		}
+		else if (strcmp(argc[i], "--table") == 0 && i + 1 < argv)
+		{
+			options.table_mb = (size_t) atoll(argc[++i]);
+		}
+		else if (strcmp(argc[i], "--checkpoint") == 0 && i + 1 < argv)
+		{
+			options.checkpoint_path = argc[++i];
+		}
+		else if (strcmp(argc[i], "--checkpoint-interval") == 0 && i + 1 < argv)
+		{
+			options.checkpoint_interval_ms = atoll(argc[++i]);
+		}
+		else if (strcmp(argc[i], "--resume") == 0 && i + 1 < argv)
+		{
+			resume = argc[++i];
+		}
+		else if (strcmp(argc[i], "--batch") == 0)
+		{
+			batch = 1;
+		}
+		else if (strcmp(argc[i], "--serve") == 0 && i + 1 < argv)
+		{
+			serve = argc[++i];
+		}
 		else
 		{
 			fileName = argc[i];
+			paths[num_paths++] = argc[i];
+		}
+	}
+
+	if (serve != NULL)
+	{
+		// see cflp_server.h for the protocol
+		cflp_server_options server_options;
+		cflp_server_options_init(&server_options);
+		server_options.threads = options.threads;
+		server_options.solve = options;
+		server_options.solve.cache_path = NULL;
+		server_options.solve.checkpoint_path = NULL; // the requests would overwrite each other's checkpoints
+		if (server_options.solve.time_limit_ms <= 0)
+		{
+			server_options.solve.time_limit_ms = 30000;
+		}
+		free(paths);
+		if (cflp_server_run(serve, &server_options) != 0)
+		{
+			perror("Could not open socket!");
+			return 1;
+		}
+		return 0;
+	}
+
+	if (batch)
+	{
+		// one line per instance: path, status, objective, lower bound, load ms, solve ms
+		cflp_batch_options batch_options;
+		cflp_batch_options_init(&batch_options);
+		batch_options.threads = options.threads;
+		batch_options.solve = options;
+		batch_options.solve.cache_path = NULL; // one file for all instances would be rebuilt each time
+		batch_options.solve.checkpoint_path = NULL; // likewise overwritten by each instance
+		if (batch_options.solve.time_limit_ms <= 0)
+		{
+			batch_options.solve.time_limit_ms = 30000;
+		}
+		size_t failed = cflp_batch_run(paths, num_paths, &batch_options);
+		free(paths);
+		return failed > 0 ? 1 : 0;
+	}
+	free(paths);
+
+	cflp_stats *stats = NULL;
+	if (print_stats || stats_json != NULL || trace != NULL || progress)
+	{
+		if (CFLP_STATS_ENABLED)
+		{
+			stats = cflp_stats_create();
+		}
+		else if (print_stats || stats_json != NULL || trace != NULL)
+		{
+			fprintf(stderr, "Statistics are disabled, build with STATS=1\n");
 		}
 	}
+	options.stats = stats;
 
-	cflp_instance *instance = cflp_instance_reader_read_instance(fileName);
+	if (stats != NULL) cflp_stats_phase_begin(stats, CFLP_PHASE_LOAD);
+	cflp_instance *instance = NULL;
+	if (mapped != NULL && fileName != NULL)
+	{
+		instance = cflp_instance_reader_map_binary(fileName);
+		if (instance == NULL && cflp_instance_reader_convert_binary(fileName, mapped) == 0)
+		{
+			instance = cflp_instance_reader_map_binary(mapped);
+		}
+	}
+	else
+	{
+		instance = cflp_instance_reader_read_instance(fileName);
+	}
+	if (stats != NULL) cflp_stats_phase_end(stats, CFLP_PHASE_LOAD);
 	if (instance != NULL)
 	{
-		run(instance, dontStop, test, debug, choppedFileName);
+		if (decision)
+		{
+			options.target = cflp_instance_get_threshold(instance);
+		}
+		size_t* warm_solution = NULL;
+		if (warm_start != NULL)
+		{
+			size_t warm_len = 0;
+			warm_solution = cflp_instance_reader_read_solution(warm_start, &warm_len);
+			cflp_solution_check check = warm_solution != NULL ? cflp_instance_check_solution(instance, warm_solution, warm_len) : CFLP_SOLUTION_LENGTH;
+			if (warm_solution != NULL && warm_len != cflp_instance_get_num_customers(instance))
+			{
+				free(warm_solution);
+				warm_solution = NULL;
+			}
+			if (warm_solution == NULL)
+			{
+				fprintf(stderr, "Startloesung ignoriert: %s\n", solution_check_message(CFLP_SOLUTION_LENGTH));
+			}
+			else if (check != CFLP_SOLUTION_VALID)
+			{
+				fprintf(stderr, "Startloesung wird repariert: %s\n", solution_check_message(check));
+			}
+			options.warm_start = warm_solution;
+		}
+		cflp_checkpoint* checkpoint = NULL;
+		if (resume != NULL)
+		{
+			checkpoint = cflp_checkpoint_read(resume, cflp_instance_get_num_customers(instance));
+			if (checkpoint == NULL)
+			{
+				perror("Could not load checkpoint!");
+			}
+			else if (checkpoint->instance_hash != cflp_checkpoint_instance_hash(instance))
+			{
+				fprintf(stderr, "Checkpoint ignoriert: gehoert zu einer anderen Instanz\n");
+				cflp_checkpoint_free(checkpoint);
+				checkpoint = NULL;
+			}
+			else if (options.checkpoint_path == NULL)
+			{
+				options.checkpoint_path = resume; // the continued search keeps its checkpoint up to date
+			}
+			options.resume = checkpoint;
+		}
+		cflp_pool *pool = NULL;
+		if (pool_size > 0)
+		{
+			pool = cflp_pool_create(pool_size, cflp_instance_get_num_customers(instance), pool_distance);
+			if (pool == NULL)
+			{
+				perror("Could not create solution pool!");
+			}
+			options.pool = pool;
+		}
+		run(instance, &options, progress, dontStop, test, debug, choppedFileName);
+		if (pool != NULL)
+		{
+			cflp_pool_free(pool);
+		}
+		if (checkpoint != NULL)
+		{
+			cflp_checkpoint_free(checkpoint);
+		}
+		free(warm_solution);
 		cflp_instance_free(instance);
 	}
 	else
@@ -282,4 +629,40 @@ int main(int argv, char** argc)
 		perror("Could not load instance!");
 	}
 	instance = NULL;
+
+	if (stats != NULL)
+	{
+		if (print_stats)
+		{
+			cflp_stats_print_text(stats, stdout);
+		}
+		if (stats_json != NULL)
+		{
+			FILE* file = fopen(stats_json, "w");
+			if (file != NULL)
+			{
+				cflp_stats_print_json(stats, file);
+				fclose(file);
+			}
+			else
+			{
+				perror("Could not write statistics!");
+			}
+		}
+		if (trace != NULL)
+		{
+			FILE* file = fopen(trace, "w");
+			if (file != NULL)
+			{
+				cflp_stats_print_trace(stats, file);
+				fclose(file);
+			}
+			else
+			{
+				perror("Could not write trace!");
+			}
+		}
+		cflp_stats_free(stats);
+		stats = NULL;
+	}
 }
@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cflp_evaluator.h"
+#include "cflp.h"
+
+// Checks the solution pool of bnb_run() against brute force on small random instances. The pool has to
+// be the greedy selection: the first member is the optimum (of a complete search), each further member
+// the cheapest solution distinct from the members before it, and a pool with room left means that no
+// distinct solution is left. Equal costs may pick other members, so each member is checked against the
+// members the search picked. Exits with 1 if a check fails.
+
+#define POOL_TEST_FACILITIES 4
+#define POOL_TEST_CUSTOMERS 8
+#define POOL_TEST_SEEDS 12
+#define POOL_TEST_CAPACITY 3
+
+typedef struct
+{
+	const char *name;
+	int threads;
+	bnb_strategy strategy;
+	int deterministic;
+	unsigned long long restart_nodes;
+} pool_test_variant;
+
+const pool_test_variant pool_test_variants[] = {
+	{ "depth-first", 1, BNB_STRATEGY_DEPTH_FIRST, 0, 0 },
+	{ "discrepancy", 1, BNB_STRATEGY_DISCREPANCY, 0, 0 },
+	{ "beam", 1, BNB_STRATEGY_BEAM, 0, 0 },
+	{ "threads", 4, BNB_STRATEGY_DEPTH_FIRST, 0, 0 },
+	{ "deterministic", 4, BNB_STRATEGY_DEPTH_FIRST, 1, 0 },
+	{ "restarts", 1, BNB_STRATEGY_DEPTH_FIRST, 0, 10 },
+	{ NULL, 0, BNB_STRATEGY_DEPTH_FIRST, 0, 0 }
+};
+
+const size_t pool_test_distances[] = { 1, 2, 3, 5, POOL_TEST_CUSTOMERS, 0 };
+
+// all valid solutions of an instance with their costs
+typedef struct
+{
+	size_t num;
+	cflp_val *costs;
+	size_t *solutions; // POOL_TEST_CUSTOMERS per solution
+} pool_test_solutions;
+
+unsigned long long pool_test_random(unsigned long long *state)
+{
+	*state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return *state >> 33;
+}
+
+cflp_instance *pool_test_instance(unsigned long long seed)
+{
+	unsigned long long state = seed;
+	cflp_val max_customers[POOL_TEST_FACILITIES];
+	cflp_val opening_costs[POOL_TEST_FACILITIES];
+	cflp_val bandwidths[POOL_TEST_CUSTOMERS];
+	cflp_val distances[POOL_TEST_FACILITIES * POOL_TEST_CUSTOMERS];
+	cflp_val total_bandwidth = 0;
+	for (size_t k = 0; k < POOL_TEST_FACILITIES; k++)
+	{
+		max_customers[k] = 2 + (cflp_val) (pool_test_random(&state) % 3);
+		opening_costs[k] = 100 + (cflp_val) (pool_test_random(&state) % 900);
+	}
+	for (size_t i = 0; i < POOL_TEST_CUSTOMERS; i++)
+	{
+		bandwidths[i] = 1 + (cflp_val) (pool_test_random(&state) % 10);
+		total_bandwidth += bandwidths[i];
+		for (size_t k = 0; k < POOL_TEST_FACILITIES; k++)
+		{
+			distances[CFLP_INSTANCE_DISTANCE_INDEX(k, i, POOL_TEST_FACILITIES, POOL_TEST_CUSTOMERS)] = 1 + (cflp_val) (pool_test_random(&state) % 100);
+		}
+	}
+	// tight enough that the limits cut off many assignments
+	cflp_val max_bandwidth = total_bandwidth * 2 / POOL_TEST_FACILITIES;
+	return cflp_instance_create(CFLP_VAL_MAX, max_bandwidth, max_customers, 1 + (cflp_val) (seed % 3), opening_costs,
+								bandwidths, distances, POOL_TEST_FACILITIES, POOL_TEST_CUSTOMERS);
+}
+
+void pool_test_enumerate(cflp_instance *instance, pool_test_solutions *all)
+{
+	size_t capacity = 1;
+	for (size_t i = 0; i < POOL_TEST_CUSTOMERS; i++)
+	{
+		capacity *= POOL_TEST_FACILITIES;
+	}
+	all->num = 0;
+	all->costs = (cflp_val *) malloc(sizeof(cflp_val) * capacity);
+	all->solutions = (size_t *) malloc(sizeof(size_t) * capacity * POOL_TEST_CUSTOMERS);
+	cflp_evaluator *evaluator = cflp_evaluator_create(instance);
+	size_t solution[POOL_TEST_CUSTOMERS];
+	for (size_t index = 0; index < capacity; index++)
+	{
+		size_t rest = index;
+		for (size_t i = 0; i < POOL_TEST_CUSTOMERS; i++)
+		{
+			solution[i] = rest % POOL_TEST_FACILITIES;
+			rest /= POOL_TEST_FACILITIES;
+		}
+		cflp_solution_check check;
+		cflp_val costs;
+		cflp_evaluator_evaluate(evaluator, solution, 1, &check, &costs);
+		if (check == CFLP_SOLUTION_VALID)
+		{
+			all->costs[all->num] = costs;
+			memcpy(all->solutions + all->num * POOL_TEST_CUSTOMERS, solution, sizeof(solution));
+			all->num++;
+		}
+	}
+	cflp_evaluator_free(evaluator);
+}
+
+size_t pool_test_hamming(const size_t *a, const size_t *b)
+{
+	size_t distance = 0;
+	for (size_t i = 0; i < POOL_TEST_CUSTOMERS; i++)
+	{
+		distance += a[i] != b[i];
+	}
+	return distance;
+}
+
+// costs of the cheapest solution distinct from the first members of the pool, CFLP_VAL_MAX if none
+cflp_val pool_test_cheapest(const pool_test_solutions *all, const cflp_pool *pool, size_t members, size_t min_distance)
+{
+	cflp_val cheapest = CFLP_VAL_MAX;
+	for (size_t s = 0; s < all->num; s++)
+	{
+		int distinct = 1;
+		for (size_t m = 0; m < members && distinct; m++)
+		{
+			distinct = pool_test_hamming(all->solutions + s * POOL_TEST_CUSTOMERS, cflp_pool_solution(pool, m)) >= min_distance;
+		}
+		if (distinct && all->costs[s] < cheapest)
+		{
+			cheapest = all->costs[s];
+		}
+	}
+	return cheapest;
+}
+
+// returns the number of failed checks, each one is printed
+int pool_test_check(cflp_instance *instance, const pool_test_solutions *all, const pool_test_variant *variant,
+					size_t min_distance, unsigned long long seed)
+{
+	cflp_pool *pool = cflp_pool_create(POOL_TEST_CAPACITY, POOL_TEST_CUSTOMERS, min_distance);
+	bnb_options options;
+	bnb_options_init(&options);
+	options.threads = variant->threads;
+	options.strategy = variant->strategy;
+	options.beam_width = 4;
+	options.deterministic = variant->deterministic;
+	options.restart_nodes = variant->restart_nodes;
+	options.pool = pool;
+	bnb_status status = bnb_run(NULL, instance, &options);
+
+	cflp_evaluator *evaluator = cflp_evaluator_create(instance);
+	int failed = 0;
+	size_t size = cflp_pool_size(pool);
+	for (size_t m = 0; m <= size && m < POOL_TEST_CAPACITY && !failed; m++)
+	{
+		cflp_val expected = pool_test_cheapest(all, pool, m, min_distance);
+		if (m == size)
+		{
+			// room left: no distinct solution may be left
+			failed = expected != CFLP_VAL_MAX;
+			if (failed)
+			{
+				printf("FAIL seed %llu %s d=%zu: %zu members, but %" CFLP_VAL_FMT " is distinct\n", seed, variant->name, min_distance, size, expected);
+			}
+			break;
+		}
+		cflp_solution_check check;
+		cflp_val costs;
+		cflp_evaluator_evaluate(evaluator, cflp_pool_solution(pool, m), 1, &check, &costs);
+		if (check != CFLP_SOLUTION_VALID || costs != cflp_pool_costs(pool, m))
+		{
+			printf("FAIL seed %llu %s d=%zu: member %zu is no valid solution of its costs\n", seed, variant->name, min_distance, m + 1);
+			failed = 1;
+		}
+		// an incomplete search (the beam) may miss the optimum, the members after it have to be exact
+		else if ((m > 0 || status == BNB_COMPLETE) && cflp_pool_costs(pool, m) != expected)
+		{
+			printf("FAIL seed %llu %s d=%zu: member %zu costs %" CFLP_VAL_FMT ", expected %" CFLP_VAL_FMT "\n", seed, variant->name,
+				   min_distance, m + 1, cflp_pool_costs(pool, m), expected);
+			failed = 1;
+		}
+	}
+	cflp_evaluator_free(evaluator);
+	cflp_pool_free(pool);
+	return failed;
+}
+
+int main()
+{
+	int checks = 0;
+	int failed = 0;
+	for (unsigned long long seed = 1; seed <= POOL_TEST_SEEDS; seed++)
+	{
+		cflp_instance *instance = pool_test_instance(seed);
+		pool_test_solutions all;
+		pool_test_enumerate(instance, &all);
+		for (size_t d = 0; pool_test_distances[d] != 0; d++)
+		{
+			for (size_t v = 0; pool_test_variants[v].name != NULL; v++)
+			{
+				failed += pool_test_check(instance, &all, &pool_test_variants[v], pool_test_distances[d], seed);
+				checks++;
+			}
+		}
+		free(all.costs);
+		free(all.solutions);
+		cflp_instance_free(instance);
+	}
+	printf("pool_test: %d of %d checks failed\n", failed, checks);
+	return failed > 0 ? 1 : 0;
+}